@@ -3,6 +3,7 @@
 #pragma once
 #include <stdint.h>
 #include <functional>
+#include <atomic>
 #include "esp_timer.h"
 
 class MidiClock {
@@ -11,7 +12,9 @@ public:
         SYNC_EXTERNAL,
         SYNC_MICROS,
         SYNC_ISR,
-        SYNC_ESP_TIMER
+        SYNC_ESP_TIMER,
+        SYNC_AUDIO,         // internal tempo counted in audio samples, advance() per block
+        SYNC_AUDIO_EXT      // incoming 0xF8 stamped in samples and smoothed by a PLL, advance() per block
     };
 
     using TickCallback = std::function<void(uint32_t tick)>;
@@ -41,6 +44,17 @@ public:
 	void continueSync();
 	void resetSync();
 
+    // --- audio clocked sources (SYNC_AUDIO, SYNC_AUDIO_EXT) ---
+    void setSampleRate(float sr);
+    // audio task, once per block before rendering it
+    void advance(uint32_t frames);
+    // MIDI task: 0xF8 received at sample position samplePos (see RDX_Transport::stamp())
+    void externalTick(uint32_t samplePos);
+    // beat position at the start of the last advanced block, and its rate
+    double getBeatPos() const { return blockBeat_; }
+    float getBeatsPerSample() const { return incPerSample_ / ppqn_; }
+    bool isAudioClocked() const { return syncSource_ >= SYNC_AUDIO; }
+
 
 private:
     volatile bool tickFlag_ = false;
@@ -59,10 +73,34 @@ private:
 
     esp_timer_handle_t espTimerHandle_ = nullptr;
 
+    // audio clocked state, owned by the audio task
+    float sampleRate_ = 48000.0f;
+    double phase_ = 0.0;           // position in internal ticks
+    double blockBeat_ = 0.0;
+    float incPerSample_ = 0.0f;    // internal ticks per sample
+    uint32_t samplePos_ = 0;
+    uint32_t extCount_ = 0;        // external ticks since start
+    uint32_t lastExtStamp_ = 0;
+    float extPeriod_ = 0.0f;       // samples per external tick, filtered
+    static constexpr float PLL_FREQ_K  = 0.02f;   // period smoothing, ~50 ticks (two beats)
+    static constexpr float PLL_PHASE_K = 0.1f;    // phase correction per tick
+
+    // MIDI task -> audio task
+    static constexpr uint8_t STAMP_RING = 16;
+    uint32_t stamps_[STAMP_RING] = {};
+    std::atomic<uint8_t> stampHead_{0};
+    std::atomic<uint8_t> stampTail_{0};
+    enum : uint8_t { CMD_NONE = 0, CMD_START, CMD_STOP, CMD_CONTINUE };
+    std::atomic<uint8_t> cmd_{CMD_NONE};
+
+    void consumeStamps();
+
     static void IRAM_ATTR espTimerCallback(void* arg);
 
-    void produceTick();
     void calculateTickInterval();
+
+protected:
+    virtual void produceTick();
 };
 
 inline MidiClock::MidiClock()
@@ -88,9 +126,11 @@ inline MidiClock::~MidiClock() {
 inline void MidiClock::calculateTickInterval() {
     if (bpm_ <= 0 || ppqn_ == 0) {
         tickIntervalMicros_ = 0;
+        incPerSample_ = 0.0f;
         return;
     }
     tickIntervalMicros_ = static_cast<uint32_t>(60000000.0f / (bpm_ * ppqn_));
+    incPerSample_ = bpm_ * ppqn_ / (60.0f * sampleRate_);
 }
 
 inline void MidiClock::begin(SyncSource source, uint8_t newPpqn, float newBpm) {
@@ -141,6 +181,7 @@ inline void MidiClock::setPPQN(uint8_t newPpqn) {
 }
 
 inline void MidiClock::start() {
+    if (isAudioClocked()) { cmd_.store(CMD_START, std::memory_order_release); return; }
     if (running_) return;
     running_ = true;
     lastMicros_ = micros();
@@ -152,6 +193,7 @@ inline void MidiClock::start() {
 }
 
 inline void MidiClock::stop() {
+    if (isAudioClocked()) { cmd_.store(CMD_STOP, std::memory_order_release); return; }
     running_ = false;
 
     if (syncSource_ == SYNC_ESP_TIMER && espTimerHandle_) {
@@ -226,6 +268,10 @@ inline void MidiClock::process() {
         case SYNC_ESP_TIMER:
             // esp_timer calls produceTick directly, no process() needed here
             break;
+        case SYNC_AUDIO:
+        case SYNC_AUDIO_EXT:
+            // advance() from the audio task
+            break;
     }
 }
 
@@ -278,16 +324,19 @@ inline void IRAM_ATTR MidiClock::espTimerCallback(void* arg) {
 }
 
 inline void MidiClock::startSync() {
+    if (isAudioClocked()) { cmd_.store(CMD_START, std::memory_order_release); return; }
     resetSync();
     running_ = true;
     lastMicros_ = micros();
 }
 
 inline void MidiClock::stopSync() {
+    if (isAudioClocked()) { cmd_.store(CMD_STOP, std::memory_order_release); return; }
     running_ = false;
 }
 
 inline void MidiClock::continueSync() {
+    if (isAudioClocked()) { cmd_.store(CMD_CONTINUE, std::memory_order_release); return; }
     running_ = true;
     lastMicros_ = micros();
 }
@@ -296,3 +345,78 @@ inline void MidiClock::resetSync() {
     tickCount_ = 0;
     lastMicros_ = micros();
 }
+
+inline void MidiClock::setSampleRate(float sr) {
+    sampleRate_ = sr;
+    calculateTickInterval();
+}
+
+inline void MidiClock::externalTick(uint32_t samplePos) {
+    const uint8_t head = stampHead_.load(std::memory_order_relaxed);
+    const uint8_t next = (head + 1) % STAMP_RING;
+    if (next == stampTail_.load(std::memory_order_acquire)) return; // audio task stalled, drop
+    stamps_[head] = samplePos;
+    stampHead_.store(next, std::memory_order_release);
+}
+
+inline void MidiClock::consumeStamps() {
+    uint8_t tail = stampTail_.load(std::memory_order_relaxed);
+    const uint8_t head = stampHead_.load(std::memory_order_acquire);
+    const float ticksPerExt = (float)ppqn_ / external_ppqn_;
+    while (tail != head) {
+        const uint32_t stamp = stamps_[tail];
+        tail = (tail + 1) % STAMP_RING;
+        if (!running_) continue;
+
+        if (extCount_ > 0) {
+            const float d = (float)(uint32_t)(stamp - lastExtStamp_);
+            if (d > 0.0f && d < sampleRate_) {  // slower than 2.5 bpm is a gap, not a tempo
+                extPeriod_ = (extPeriod_ > 0.0f) ? extPeriod_ + PLL_FREQ_K * (d - extPeriod_) : d;
+                incPerSample_ = ticksPerExt / extPeriod_;
+                bpm_ = 60.0f * sampleRate_ / (extPeriod_ * external_ppqn_);
+            }
+        }
+        lastExtStamp_ = stamp;
+        ++extCount_;
+
+        // where the tick should be vs where our phase is at that sample
+        const double target = (double)(extCount_ - 1) * ticksPerExt;
+        const double est = phase_ + (double)incPerSample_ * (double)(int32_t)(stamp - samplePos_);
+        const double err = target - est;
+        if (err > ppqn_ || err < -ppqn_) {
+            phase_ += err;                  // lost, snap
+        } else {
+            phase_ += PLL_PHASE_K * err;
+        }
+    }
+    stampTail_.store(tail, std::memory_order_release);
+}
+
+inline void MidiClock::advance(uint32_t frames) {
+    switch (cmd_.exchange(CMD_NONE, std::memory_order_acquire)) {
+        case CMD_START:
+            phase_ = 0.0;
+            tickCount_ = 0;
+            extCount_ = 0;
+            running_ = true;
+            break;
+        case CMD_STOP:
+            running_ = false;
+            break;
+        case CMD_CONTINUE:
+            running_ = true;
+            break;
+        default:
+            break;
+    }
+    if (syncSource_ == SYNC_AUDIO_EXT) consumeStamps();
+
+    blockBeat_ = phase_ / ppqn_;
+    if (running_) {
+        phase_ += (double)incPerSample_ * frames;
+        while ((double)tickCount_ < phase_) {
+            produceTick();
+        }
+    }
+    samplePos_ += frames;
+}
@@ -19,6 +19,7 @@ int VOICES = MAX_VOICES;
 #include "RDX_Midi.h"
 #include "src/i2s/i2s_in_out.h"
 #include "RDX_FX.h"
+#include "RDX_AudioTap.h"
 
 #include "controls.h"
 
@@ -30,13 +31,24 @@ int VOICES = MAX_VOICES;
 
 constexpr char* TAG = "RDX";
 
-float DRAM_ATTR outL[DMA_BUFFER_LEN];
-float DRAM_ATTR outR[DMA_BUFFER_LEN];
+float DRAM_ATTR outL[MAX_BLOCK_LEN];
+float DRAM_ATTR outR[MAX_BLOCK_LEN];
+
+#if AUDIO_INPUT
+  #if I2S_DIN_PIN < 0
+    #error "AUDIO_INPUT needs I2S_DIN_PIN"
+  #endif
+float DRAM_ATTR inL[MAX_BLOCK_LEN];
+float DRAM_ATTR inR[MAX_BLOCK_LEN];
+#endif
 
 // debug
 volatile int time1, time2 = 0;
 uint32_t audioWM = 0, midiWM = 0, guiWM = 0;
-float rmsL = 0.f, rmsR = 0.f; 
+
+#if RDX_AUDIO_TAP
+RDX_AudioTap tap;   // audio task -> meters and the scope page
+#endif
 
 RDX_Synth synth;
 I2S_Audio audio;
@@ -46,6 +58,7 @@ PresetManager pm;
 TaskHandle_t audioTaskHandle;
 TaskHandle_t midiTaskHandle;
 TaskHandle_t guiTaskHandle = nullptr;
+TaskHandle_t patchTaskHandle = nullptr;
  
 
 static FXHost fx;
@@ -58,25 +71,156 @@ static FXHost fx;
 
 
 
+// ------------------- Audio block setup -----------------
+// Asks for a new block length / DMA buffer count, the audio task switches at the next block boundary.
+// Block length must be a multiple of 16 within MIN_BLOCK_LEN..MAX_BLOCK_LEN.
+bool requestAudioBlock(uint32_t len, uint32_t bufs) {
+    if (len < MIN_BLOCK_LEN || len > MAX_BLOCK_LEN || (len & 15) || bufs < 2 || bufs > MAX_DMA_BUFFER_NUM) {
+        ESP_LOGE(TAG, "Audio block %d x %d rejected", (int)len, (int)bufs);
+        return false;
+    }
+    RDX_AudioConfig& ac = RDX_State::getState().audio;
+    ac.wantBlockLen = len;
+    ac.wantDmaBufNum = bufs;
+    ac.changePending = true;
+    return true;
+}
+
+static void applyAudioBlock() {
+    RDX_AudioConfig& ac = RDX_State::getState().audio;
+    ac.changePending = false;
+    if (!audio.reconfigure(ac.wantBlockLen, ac.wantDmaBufNum)) return;
+    ac.blockLen = audio.getBufLenSmp();
+    ac.dmaBufNum = audio.getBufNum();
+    ac.divBlockLen = 1.0f / ac.blockLen;
+    fx.setBlockLen(ac.blockLen);
+    ESP_LOGI(TAG, "Audio block %d samples x %d buffers, output latency %.2f ms, round trip %.2f ms, FX budget %d us",
+             (int)ac.blockLen, (int)ac.dmaBufNum, ac.outputLatencyMs(), ac.roundTripLatencyMs(), fx.getCpuBudget());
+}
+
+// ------------------- NRPN setup -----------------------
+// see RDX_Midi.h for the map; runs in the MIDI task
+void rdxSetNrpn(uint8_t msb, uint8_t lsb, uint8_t val) {
+    if (msb >= NRPN_PART && msb < NRPN_PART + RDX_PARTS) {
+        const uint8_t p = msb - NRPN_PART;
+        RDX_Part& pt = synth.part(p);
+        uint8_t ch = pt.channel, lo = pt.keyLow, hi = pt.keyHigh, vol = pt.volume, res = pt.reserve;
+        switch (lsb) {
+            case 0: synth.enablePart(p, val > 0); return;
+            case 1: ch = val; break;
+            case 2: lo = val; break;
+            case 3: hi = val; break;
+            case 4: vol = val; break;
+            case 5: res = val > MAX_VOICES ? MAX_VOICES : val; break;
+            case 6: pt.priority = val > RDX_PRIO_HIGH ? RDX_PRIO_LAST : val; return;
+            default: return;
+        }
+        // a new channel or key range releases what the part holds
+        if (lsb <= 3) synth.enablePart(p, false);
+        synth.setPart(p, ch, lo, hi, vol, res);
+    } else if (msb >= NRPN_FX && msb < NRPN_FX + FX_SLOTS) {
+        const uint8_t s = msb - NRPN_FX;
+        const uint8_t* sp = fx.getSlotParams(s);
+        uint8_t prm[3] = { sp[0], sp[1], sp[2] };
+        switch (lsb) {
+            case 0: case 1: case 2:
+                if (s < FX_PATCH_SLOTS) return;     // patch slots follow RDX_Common::effects[]
+                prm[lsb] = val;
+                fx.setSlotParams(s, (FX_ID)prm[0], prm[1], prm[2]);
+                break;
+            case 3: fx.setRoute(s, val ? FX_ROUTE_PARALLEL : FX_ROUTE_SERIAL, fx.getSend(s)); break;
+            case 4: fx.setRoute(s, fx.getRoute(s), val * MIDI_NORM); break;
+        }
+    } else if (msb == NRPN_SYSTEM) {
+        SynthState& st = RDX_State::getState();
+        switch (lsb) {
+            case 0: st.controls.lfoSync   = val <= TEMPO_1_8D ? val : TEMPO_FREE; break;
+            case 1: st.controls.delaySync = val <= TEMPO_1_8D ? val : TEMPO_FREE; break;
+            case 2: requestAudioBlock(val * 16, st.audio.dmaBufNum); break;
+            case 3: requestAudioBlock(st.audio.blockLen, val); break;
+        }
+    }
+}
+
+// ------------------- Transport -----------------------
+// MIDI clock runs on the sample counter, the LFOs and the delay pick the tempo up from here
+static void advanceTransport(uint32_t len) {
+    static float fxBpm = 0.0f;
+    static uint8_t fxDiv = TEMPO_FREE;
+    RDX_Transport& tr = RDX_State::getState().transport;
+    const uint8_t div = RDX_State::getState().controls.delaySync;
+    tr.blockStartUs = micros();
+    midiClock.advance(len);
+    tr.beat = midiClock.getBeatPos();
+    tr.beatsPerSample = midiClock.getBeatsPerSample();
+    tr.bpm = midiClock.getBPM();
+    tr.running = midiClock.isRunning();
+    if (div != fxDiv || fabsf(tr.bpm - fxBpm) >= 0.25f) {
+        fxBpm = tr.bpm;
+        fxDiv = div;
+        fx.setTempo(fxBpm, fxDiv);
+    }
+}
+
 // ------------------- Audio Task -----------------------
 static void IRAM_ATTR audioTask(void*) {
+    RDX_AudioConfig& ac = RDX_State::getState().audio;
+#if AUDIO_INPUT
+    const RDX_Controls& ctrl = RDX_State::getState().controls;
+    bool sidechain = false;
+#endif
     vTaskDelay(30);
     ESP_LOGI(TAG, "Starting Audio task");
     vTaskDelay(50); 
     while (true) {
+        if (ac.changePending) applyAudioBlock();
+        const uint32_t len = ac.blockLen;
+
+#if AUDIO_INPUT
+        // rx and tx run off one clock, so this just waits for the block that lines up with the next write
+        const bool haveInput = audio.readBuffers(inL, inR);
+#endif
+
+        advanceTransport(len);
+
         uint32_t start = micros();
 
-        synth.renderAudioBlock(outL, outR); 
+        synth.renderAudioBlock(outL, outR, len); 
+
+#if AUDIO_INPUT
+        if (haveInput) {
+            const float g = ctrl.inputLevel;
+            if (g > 0.0f) {
+                for (uint32_t i = 0; i < len; ++i) {
+                    outL[i] += inL[i] * g;
+                    outR[i] += inR[i] * g;
+                }
+            }
+        }
+        if (sidechain != (ctrl.inputSidechain && haveInput)) {
+            sidechain = !sidechain;
+            fx.setSidechain(sidechain ? inL : nullptr, sidechain ? inR : nullptr);
+        }
+#endif
         
         uint32_t end = micros();
 
         time1 = end - start; 
 
-		fx.process(outL, outR );
+		fx.process(outL, outR, len);
 
         time2 = micros() - end;
 
         audio.writeBuffers(outL, outR);
+        RDX_State::getState().transport.samplePos += len;
+
+#if RDX_AUDIO_TAP
+        tap.write(outL, outR, len);
+        for (int v = 0; v < VOICES; ++v) {
+            const RDX_Voice& voice = synth.getVoice(v);
+            tap.writeVoice(v, voice.isActive() ? voice.ampScore() : 0.0f);
+        }
+#endif
         
     }
 }
@@ -84,32 +228,30 @@ static void IRAM_ATTR audioTask(void*) {
 
 // ------------------- MIDI Task ------------------------
 static void IRAM_ATTR midiTask(void*) {
-    const int budgetMicros = 1e+06f * DMA_BUFFER_LEN / SAMPLE_RATE ;
+    const RDX_AudioConfig& ac = RDX_State::getState().audio;
     vTaskDelay(40);
     ESP_LOGI(TAG, "Starting MIDI task");
     vTaskDelay(40);
     int d = 0;
     while (true) {
+        // the USB/UART drivers notify on traffic, the timeout keeps the controls polled
+        ulTaskNotifyTake(pdTRUE, 1);
         processMidi();   // incoming messages
-        vTaskDelay(1);
 
         processControls();
         taskYIELD();
-        
-        synth.updateCache(); // cache some not-so-critical params to local members to speed up hot paths
 
         if (++d % 1024 == 0) {
             midiWM = uxTaskGetStackHighWaterMark(midiTaskHandle);
             audioWM = uxTaskGetStackHighWaterMark(audioTaskHandle);
-            #if 1   // --- diagnostics
-                for (int i = 0; i < DMA_BUFFER_LEN; ++i) {
-                    rmsL += outL[i] * outL[i];
-                    rmsR += outR[i] * outR[i];
-                }
-                rmsL = sqrtf(rmsL / DMA_BUFFER_LEN);
-                rmsR = sqrtf(rmsR / DMA_BUFFER_LEN);
-            #endif
-            ESP_LOGI("STATE","synth %d + fx %d = %d of %d micros, RMS %f Free stack: audio %ld B midi %ld B gui %ld B", time1, time2, time1+time2, budgetMicros, rmsL + rmsR, audioWM, midiWM, guiWM);
+            const uint32_t len = ac.blockLen;
+            const int budgetMicros = 1e+06f * len / SAMPLE_RATE ;
+#if RDX_AUDIO_TAP
+            const float rms = tap.rmsL() + tap.rmsR();
+#else
+            const float rms = 0.0f;
+#endif
+            ESP_LOGI("STATE","synth %d + fx %d = %d of %d micros, RMS %f Free stack: audio %ld B midi %ld B gui %ld B", time1, time2, time1+time2, budgetMicros, rms, audioWM, midiWM, guiWM);
 //            for (int i = 0 ; i < VOICES; ++i) {
   //              ESP_LOGI("STATE","voice %d\t active %d\t score %f" , i, synth.getVoice(i).isActive(), synth.getVoice(i).calcScore());
     //        }
@@ -117,6 +259,24 @@ static void IRAM_ATTR midiTask(void*) {
     }
 }
 
+// ------------------- Patch Task ----------------------
+// Rescans the patch folder, seconds on a big SD folder, below everything else so MIDI
+// keeps flowing. The MIDI task skips patch changes meanwhile and loads the result.
+static void patchTask(void*) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (!pm.tryLock()) vTaskDelay(1);
+        const uint32_t cur = pm.currentIndex();
+        const bool ok = pm.rescan();
+        const uint32_t n = pm.size();
+        pm.unlock();
+        ESP_LOGI(TAG, "Rescanned: %d patches", (int)n);
+        if (ok) requestPatch(min(cur, n - 1));
+    }
+}
+
+void rdxRescanPatches() { if (patchTaskHandle) xTaskNotifyGive(patchTaskHandle); }
+
 #ifdef ENABLE_GUI
 // ------------------- GUI Task ------------------------
 static void IRAM_ATTR gui_task(void*) {
@@ -128,6 +288,18 @@ static void IRAM_ATTR gui_task(void*) {
         vTaskDelay(1);
     }
 }
+
+// front panel -> GUI, the event is handled in the GUI task
+void guiInput(UIInputType type, uint8_t id, int16_t value) { gui.input(type, id, value); }
+
+// editor pages, same path as a SysEx parameter change
+void rdxSetParam(int op, uint8_t addr, uint8_t val) {
+    if (op < 0) synth.setCommonParam(addr, val);
+    else        synth.setOperatorParam(op, addr, val);
+}
+
+// browser, the MIDI task loads it
+void rdxLoadPatch(uint32_t entry) { requestPatch(entry); }
 #endif
 
 // ------------------- Setup ---------------------------
@@ -137,9 +309,9 @@ void setup() {
 
 
 // ----------------- Filesystems --------------------
- //   SD_MMC.setPins(SDMMC_CLK, SDMMC_CMD, SDMMC_D0, SDMMC_D1, SDMMC_D2, SDMMC_D3);
- //   if (!SD_MMC.begin()) ESP_LOGE(TAG, "SD init failed");
     if (!LittleFS.begin()) ESP_LOGE(TAG, "LittleFS init failed");
+    // patches: LittleFS, or SD_MMC (4-bit) with USE_SD
+    if (!pm.begin(PATCH_FS)) ESP_LOGE(TAG, "Patch storage init failed");
 
   setupMidi() ;
   
@@ -152,22 +324,27 @@ void setup() {
    
     // ----------------- Audio -------------------------
     audio.setSampleRate(SAMPLE_RATE);
+#if AUDIO_INPUT
+    audio.init(I2S_Audio::MODE_IN_OUT);
+    ESP_LOGI(TAG, "Audio block %d samples x %d buffers, output latency %.2f ms, round trip %.2f ms", audio.getBufLenSmp(), audio.getBufNum(),
+             audio.getLatencyMs(), RDX_State::getState().audio.roundTripLatencyMs());
+#else
     audio.init(I2S_Audio::MODE_OUT);
+    ESP_LOGI(TAG, "Audio block %d samples x %d buffers, output latency %.2f ms", audio.getBufLenSmp(), audio.getBufNum(), audio.getLatencyMs());
+#endif
 
     // ----------------- Synth init ---------------------
     synth.init(); 
 
 
     RDX_Patch patch;
-  //  pm.begin(FS_Type::SD_MMC);
-    pm.begin(FS_Type::LITTLEFS);
-
-    if (pm.open(FS_Type::LITTLEFS, "/patches") ) {
+    if (pm.open(PATCH_FS, PATCH_DIR) ) {
         pm.openByIndex(25, patch); 
     } else {
         patch = synth.DigiChordPatch(); // hardcoded patch
     }
     synth.applyPatch(patch);
+    // the rest of the setup a patch doesn't hold (parts 1.. and so on) comes over NRPN, see RDX_Midi.h
 
 
     // ----------------- EFFECTS -----------------------
@@ -182,6 +359,7 @@ void setup() {
     // ----------------- Tasks -------------------------
     xTaskCreatePinnedToCore(audioTask, "audio", 4096, nullptr, 8, &audioTaskHandle, 0);
     xTaskCreatePinnedToCore(midiTask, "midi", 4096, nullptr, 5, &midiTaskHandle, 1);
+    xTaskCreatePinnedToCore(patchTask, "patch", 4096, nullptr, 1, &patchTaskHandle, 1);
 #ifdef ENABLE_GUI
     xTaskCreatePinnedToCore(gui_task, "gui", 4096, nullptr, 4, &guiTaskHandle, 1);
 #endif
@@ -0,0 +1,98 @@
+// RDX_AudioTap.h
+#pragma once
+#include <atomic>
+#include <math.h>
+#include "config.h"
+
+static_assert(16 % RDX_TAP_DECIM == 0, "RDX_TAP_DECIM must divide 16, every block length is a multiple of it");
+
+// Audio task -> GUI: a decimated mono copy of the output, peak/RMS meters and per-voice levels.
+// The audio task writes once per block without locks; a reader that gets lapped while copying
+// is told so by snapshot() and simply tries again on its next frame.
+class RDX_AudioTap {
+public:
+    static constexpr uint32_t RING = 1024;          // tap samples kept, power of 2
+    static constexpr uint32_t METER_BLOCKS = 8;     // blocks per RMS reading
+
+    // ---------------- audio task ----------------
+    inline void write(const float* L, const float* R, uint32_t len) {
+        uint32_t pos = writePos_.load(std::memory_order_relaxed);
+        float pL = 0.f, pR = 0.f;
+        for (uint32_t i = 0; i < len; i += RDX_TAP_DECIM) {
+            float acc = 0.f;
+            for (uint32_t k = i; k < i + RDX_TAP_DECIM; ++k) {
+                const float l = L[k];
+                const float r = R[k];
+                acc += l + r;
+                sqL_ += l * l;
+                sqR_ += r * r;
+                pL = fmaxf(pL, fabsf(l));
+                pR = fmaxf(pR, fabsf(r));
+            }
+            float m = acc * (0.5f / RDX_TAP_DECIM);
+            m = m > 1.f ? 1.f : (m < -1.f ? -1.f : m);
+            ring_[pos++ & (RING - 1)] = (int16_t)(m * 32767.f);
+        }
+        writePos_.store(pos, std::memory_order_release);
+
+        raisePeak(peakL_, pL);
+        raisePeak(peakR_, pR);
+        meterLen_ += len;
+        if (++meterBlocks_ == METER_BLOCKS) {
+            rmsL_.store(sqrtf(sqL_ / meterLen_), std::memory_order_relaxed);
+            rmsR_.store(sqrtf(sqR_ / meterLen_), std::memory_order_relaxed);
+            sqL_ = sqR_ = 0.f;
+            meterLen_ = 0;
+            meterBlocks_ = 0;
+        }
+    }
+
+    // carrier envelope level of a voice, 0 when idle
+    inline void writeVoice(int v, float level) {
+        if (v < MAX_VOICES) voiceLevel_[v].store((uint8_t)(fminf(level, 1.f) * 255.f), std::memory_order_relaxed);
+    }
+
+    // ---------------- readers ----------------
+    // the latest n tap samples (Q15), oldest first; false if the writer overtook the copy
+    inline bool snapshot(int16_t* dst, uint32_t n) const {
+        if (n > RING / 2) n = RING / 2;
+        const uint32_t start = writePos_.load(std::memory_order_acquire) - n;
+        for (uint32_t i = 0; i < n; ++i) dst[i] = ring_[(start + i) & (RING - 1)];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // write() fills up to a whole block of slots before it publishes writePos_
+        return writePos_.load(std::memory_order_relaxed) - start <= RING - MAX_BLOCK_LEN / RDX_TAP_DECIM;
+    }
+
+    // tap samples written so far, to tell whether there is anything new
+    inline uint32_t position() const { return writePos_.load(std::memory_order_acquire); }
+
+    // highest |sample| since the last call
+    inline float takePeakL() { return peakL_.exchange(0.f, std::memory_order_relaxed); }
+    inline float takePeakR() { return peakR_.exchange(0.f, std::memory_order_relaxed); }
+
+    inline float rmsL() const { return rmsL_.load(std::memory_order_relaxed); }
+    inline float rmsR() const { return rmsR_.load(std::memory_order_relaxed); }
+
+    inline float voiceLevel(int v) const { return voiceLevel_[v].load(std::memory_order_relaxed) * (1.f / 255.f); }
+
+    static constexpr float sampleRate() { return (float)SAMPLE_RATE / RDX_TAP_DECIM; }
+
+private:
+    // the GUI may exchange(0) in between, so a plain load-then-store could lose a peak
+    static inline void raisePeak(std::atomic<float>& peak, float p) {
+        float cur = peak.load(std::memory_order_relaxed);
+        while (p > cur && !peak.compare_exchange_weak(cur, p, std::memory_order_relaxed)) {}
+    }
+
+    int16_t                 ring_[RING] = {};
+    std::atomic<uint32_t>   writePos_{0};
+
+    std::atomic<float>      peakL_{0.f}, peakR_{0.f};
+    std::atomic<float>      rmsL_{0.f}, rmsR_{0.f};
+    std::atomic<uint8_t>    voiceLevel_[MAX_VOICES] = {};
+
+    // audio task only
+    float                   sqL_ = 0.f, sqR_ = 0.f;
+    uint32_t                meterLen_ = 0;
+    uint32_t                meterBlocks_ = 0;
+};
@@ -99,7 +99,7 @@ public:
 
 private:
 
-    RDX_Common& common_ = RDX_State::getState().workingPatch.common;
+    RDX_Common& common_ = RDX_State::getState().workingPatch().common;
     inline void enterStage(Stage s) {
         targetL_ = levelIndices_[static_cast<int>(s)];
         stage_  = s;
@@ -1,7 +1,8 @@
 #pragma once
 #include <stdint.h>
 #include <esp_log.h>
-#include <cstring> 
+#include <cstring>
+#include <new>
 
 #include "fx_base.h"
 #include "fx_reverb.h"
@@ -12,9 +13,13 @@
 #include "fx_touch_wah.h"
 #include "fx_distortion.h"
 
-#define FX_BLOCK_SIZE   DMA_BUFFER_LEN
+#define FX_BLOCK_SIZE   MAX_BLOCK_LEN   // scratch size, the actual block length is set at runtime
+#define FX_TIMING_BLOCK 128             // timings below are measured per this many samples
 #define FX_SAMPLE_RATE  SAMPLE_RATE
-#define FX_SLOTS        2
+#ifndef FX_SLOTS
+#define FX_SLOTS        4
+#endif
+#define FX_PATCH_SLOTS  2   // slots driven by RDX_Common::effects[]
 
 // =========================================================
 // Effect type enum  matches Reface DX table
@@ -30,19 +35,37 @@ enum FX_ID : uint8_t {
     FX_REVERB,
     FX_COUNT
 };
- 
+
+// =========================================================
+// Slot routing
+//  SERIAL:   bus = x + send * (fx(x) - x), i.e. send is the wet amount
+//  PARALLEL: taps the bus at its position, fx(send * x) - send * x
+//            is summed into the return bus and added after the last slot
+// =========================================================
+enum FX_Route : uint8_t {
+    FX_ROUTE_SERIAL = 0,
+    FX_ROUTE_PARALLEL
+};
+
+// biggest effect object, every slot owns one placement slab of this size
+template<typename T, typename... Ts>
+constexpr size_t fxMaxSize() {
+    if constexpr (sizeof...(Ts) == 0) return sizeof(T);
+    else return sizeof(T) > fxMaxSize<Ts...>() ? sizeof(T) : fxMaxSize<Ts...>();
+}
+
+constexpr size_t FX_POOL_OBJ_SIZE = fxMaxSize<FxThru, FxDistortion, FxTouchWah, FxChorus, FxFlanger, FxPhaser, FxDelay, FxReverb>();
 
 
 // =========================================================
-// FX Host  manages two slots and static pool
+// FX Host  manages the slot graph and the instance pool
 // =========================================================
 class FXHost {
 public:
     void init(float sampleRate = FX_SAMPLE_RATE) {
-        //here we assume that we have 210 kB of DRAM and 4+ MB of PSRAM
         sampleRate_ = sampleRate;
 
-        timing[FX_THRU]  = 0; // us per block of 128 samples
+        timing[FX_THRU]  = 0; // us per FX_TIMING_BLOCK samples
         timing[FX_DISTORTION] = 34 * TIMING_CORRECTION;
         timing[FX_TOUCHWAH] = 85 * TIMING_CORRECTION;
         timing[FX_CHORUS] = 62 * TIMING_CORRECTION;
@@ -52,117 +75,304 @@ public:
         timing[FX_REVERB] = 152 * TIMING_CORRECTION;
         voice_timing = 340 * TIMING_CORRECTION;
 
-        uint32_t dram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-        uint32_t psram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        szDRAM = (dram_largest - 8000) / FX_SLOTS / sizeof(float); // small buffers for scratch * 2 slots ~101kB per slot
-        szPSRAM = std::min((uint32_t)sampleRate * 7, psram_largest / FX_SLOTS / sizeof(float)) ; // seconds * 2 slots 
+        setBlockLen(blockLen_);
+        allocScratch();
 
-        if (!scratchDRAM[0]) {
-            scratchDRAM[0] = (float*) heap_caps_calloc(1, szDRAM * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-            scratchDRAM[1] = (float*) heap_caps_calloc(1, szDRAM * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        for (int s = 0; s < FX_SLOTS; ++s) {
+            FxSlot& sl = slot_[s];
+            sl.params[0] = FX_THRU;
+            sl.params[1] = sl.params[2] = 64;
+            // patch slots read straight from the working patch, the rest own their params
+            sl.src = (s < FX_PATCH_SLOTS) ? common_.effects[s] : sl.params;
+            sl.route = FX_ROUTE_SERIAL;
+            sl.send = 1.0f;
+            setSlot(s, FX_THRU);
         }
+        ESP_LOGI("FXHost", "Initialized FXHost @ %.1f Hz, %d slots, CPU budget %d us, obj %d bytes", sampleRate_, FX_SLOTS, cpuBudget_, FX_POOL_OBJ_SIZE);
+    }
 
-        if (!scratchPSRAM[0]) {
-            scratchPSRAM[0] = (float*) heap_caps_calloc(1, szPSRAM * sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-            scratchPSRAM[1] = (float*) heap_caps_calloc(1, szPSRAM * sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    // Block length the audio task renders with. The budget is kept in FX_TIMING_BLOCK units,
+    // the fixed 50us per-block gap weighs more as blocks get shorter.
+    inline void setBlockLen(uint32_t n) {
+        if (n < MIN_BLOCK_LEN) n = MIN_BLOCK_LEN;
+        if (n > MAX_BLOCK_LEN) n = MAX_BLOCK_LEN;
+        blockLen_ = n;
+        blockUs_ = 1e+06f * n / sampleRate_;
+        timeScale_ = (float)n / (float)FX_TIMING_BLOCK;
+        // whatever is left after the minimum polyphony and a 50us gap goes to the FX
+        cpuBudget_ = (int)((blockUs_ - 50.0f) / timeScale_) - FX_MIN_VOICES * voice_timing;
+        // what didn't fit the old budget may fit this one, process() tries again
+        for (int s = 0; s < FX_SLOTS; ++s) slot_[s].rejected = 0xFF;
+        // a shorter block leaves less: drop effects from the last slot back until the rest fits,
+        // they come back when the budget grows again
+        for (int s = FX_SLOTS - 1; s >= 0 && fxTime_ > cpuBudget_; --s) {
+            FxSlot& sl = slot_[s];
+            if (sl.id == FX_THRU) continue;
+            ESP_LOGW("FXHost", "Slot %d: FX %d dropped, FX time %d us exceeds the budget %d us at block %d", s, sl.id, fxTime_, cpuBudget_, (int)n);
+            reject(s, sl.id);
         }
+    }
 
-        if (!scratchDRAM[1] || !scratchPSRAM[1]) {
-            ESP_LOGE("FX","Unable to allocate scratch arrays DRAM: %#010x, PSRAM: %#010x", scratchDRAM[1], scratchPSRAM[1] );
-            delay(100);
-            while (1) {;}
-        } else {            
-            ESP_LOGI("FX","Allocated scratch arrays [slot0] DRAM: %#010x, %dkB , PSRAM: %#010x, %dkB", scratchDRAM[0], szDRAM/1024*sizeof(float), scratchPSRAM[0], szPSRAM/1024*sizeof(float) );
-            ESP_LOGI("FX","Allocated scratch arrays [slot1] DRAM: %#010x, %dkB , PSRAM: %#010x, %dkB", scratchDRAM[1], szDRAM/1024*sizeof(float), scratchPSRAM[1], szPSRAM/1024*sizeof(float) );
+    inline IRAM_ATTR __attribute__((always_inline, hot)) void process(float* left, float* right, uint32_t n = DMA_BUFFER_LEN) {
+        if (n > FX_BLOCK_SIZE) n = FX_BLOCK_SIZE;
+        bool hasReturn = false;
+        for (int s = 0; s < FX_SLOTS; ++s) {
+            FxSlot& sl = slot_[s];
+            if (sl.id != sl.src[0] && sl.src[0] != sl.rejected) setSlot(s, (FX_ID)sl.src[0]);
+            if (sl.id == FX_THRU || sl.send <= 0.0f) continue;
+
+            if (sl.route == FX_ROUTE_SERIAL) {
+                if (sl.send >= 1.0f) {
+                    sl.fx->processBlock(left, right, n);
+                } else {
+                    memcpy(tapL_, left, n * sizeof(float));
+                    memcpy(tapR_, right, n * sizeof(float));
+                    sl.fx->processBlock(tapL_, tapR_, n);
+                    const float k = sl.send;
+                    for (uint32_t i = 0; i < n; ++i) {
+                        left[i]  += k * (tapL_[i] - left[i]);
+                        right[i] += k * (tapR_[i] - right[i]);
+                    }
+                }
+            } else {
+                if (!hasReturn) {
+                    memset(retL_, 0, n * sizeof(float));
+                    memset(retR_, 0, n * sizeof(float));
+                    hasReturn = true;
+                }
+                const float k = sl.send;
+                for (uint32_t i = 0; i < n; ++i) {
+                    tapL_[i] = left[i] * k;
+                    tapR_[i] = right[i] * k;
+                }
+                sl.fx->processBlock(tapL_, tapR_, n);
+                // keep only what the effect added, the dry part stays on the main bus
+                for (uint32_t i = 0; i < n; ++i) {
+                    retL_[i] += tapL_[i] - left[i] * k;
+                    retR_[i] += tapR_[i] - right[i] * k;
+                }
+            }
         }
-        // Initialize all instances
-        for (int i = 0; i < FX_COUNT; ++i) {
-            for (int s = 0; s < FX_SLOTS; ++s) {
-                auto* fx = getInstance((FX_ID)i, s);
-                fx->init(sampleRate, s);
-                fx->prepare(scratchDRAM[s], szDRAM, scratchPSRAM[s], szPSRAM, sampleRate); // pass both fast and slow slot buffers, so fx could decide for themselves
-                vTaskDelay(10);
+        if (hasReturn) {
+            for (uint32_t i = 0; i < n; ++i) {
+                left[i]  += retL_[i];
+                right[i] += retR_[i];
             }
         }
-        // Default to thru
-        setSlot(0, FX_THRU);
-        setSlot(1, FX_THRU);
-        ESP_LOGI("FXHost", "Initialized FXHost @ %.1f Hz", sampleRate_);
+        if (anyPolyPart()) {
+            // a unison layer repeats the oscillators but not the envelope/modulation pass
+            const float layerCost = 1.0f + (ctl_.unisonVoices - 1) * UNISON_LAYER_COST;
+            VOICES = (blockUs_ - 50 - fxTime_ * timeScale_) / (voice_timing * layerCost * timeScale_); // ~340us per voice per 128 samples on S3, polyphony estimation; 50us is a gap
+            if (VOICES > MAX_VOICES) VOICES = MAX_VOICES;
+            if (VOICES < 1) VOICES = 1;
+        } else {
+            VOICES = 1;
+        }
     }
 
-    inline IRAM_ATTR __attribute__((always_inline, hot)) void process(float* left, float* right ) {
-        int fx_time = 0;
-        for (int s = 0; s < FX_SLOTS; ++s) {
-            if (fx_[s] != common_.effects[s][0]) setSlot(s, (FX_ID)common_.effects[s][0]);
-            if (slots_[s]) slots_[s]->processBlock(left, right, FX_BLOCK_SIZE  );
-            fx_time += timing[(FX_ID)common_.effects[s][0]];
+    // Puts an effect into the slot right away, call it from the audio task or before it starts.
+    // Fails (and leaves FX_THRU there) if the effect doesn't fit into the CPU budget,
+    // the slot's scratch is too small for it or it can't bind that scratch.
+    // Nothing is allocated here, the scratch comes from init().
+    inline bool setSlot(uint8_t slot, FX_ID id) {
+        if (slot >= FX_SLOTS) return false;
+        if (id >= FX_COUNT) return reject(slot, id);
+        FxSlot& sl = slot_[slot];
+
+        int newTime = fxTime_ - timing[sl.id] + timing[id];
+        if (id != FX_THRU && newTime > cpuBudget_) {
+            ESP_LOGE("FXHost", "Slot %d: FX %d exceeds CPU budget (%d of %d us)", slot, id, newTime, cpuBudget_);
+            return reject(slot, id);
         }
-        if (common_.monoPoly == RDX_MODE_POLY) {
-            VOICES = (1e+06f * DMA_BUFFER_LEN / SAMPLE_RATE - 50 - fx_time) / voice_timing; // ~340ms per voice on S3, polyphony estimation; 50ms is a gap
-        } else {
-            VOICES = 1;
+
+        destroy(sl);
+        FXBase* fx = create(sl, id);
+        uint32_t fastNeed = fx->fastScratchNeeded(sampleRate_);
+        uint32_t slowNeed = fx->slowScratchNeeded(sampleRate_);
+        if (fastNeed > sl.fastCap || slowNeed > sl.slowCap) {
+            ESP_LOGE("FXHost", "Slot %d: no memory for FX %d (fast %d of %d, slow %d of %d floats)", slot, id, fastNeed, sl.fastCap, slowNeed, sl.slowCap);
+            destroy(sl);
+            return reject(slot, id);
+        }
+        if (sl.fast) memset(sl.fast, 0, fastNeed * sizeof(float));
+        if (sl.slow) memset(sl.slow, 0, slowNeed * sizeof(float));
+
+        fx->init(sampleRate_, slot);
+        fx->bindParams(sl.src);
+        fx->setSidechain(scL_, scR_);
+        fx->setTempo(bpm_, tempoDiv_);
+        if (!fx->prepare(sl.fast, sl.fastCap, sl.slow, sl.slowCap, sampleRate_)) {
+            ESP_LOGE("FXHost", "Slot %d: FX %d failed to prepare", slot, id);
+            destroy(sl);
+            return reject(slot, id);
         }
+        fx->enable(false);
+        fx->reset();
+        fx->enable(true);
+
+        fxTime_ = fxTime_ - timing[sl.id] + timing[id];
+        sl.id = id;
+        sl.rejected = 0xFF;
+        ESP_LOGI("FXHost", "Slot %d -> FX %d (FX time %d us)", slot, id, fxTime_);
+        return true;
     }
 
-    virtual void prepare(float* buf, uint32_t len, float sampleRate) { (void)buf; (void)len; (void)sampleRate; }
+    inline void setRoute(uint8_t slot, FX_Route route, float send = 1.0f) {
+        if (slot >= FX_SLOTS) return;
+        slot_[slot].route = route;
+        slot_[slot].send = fclamp(send, 0.0f, 1.0f);
+    }
 
-    inline void resetSlot(uint8_t slot) {
-        if (slot < FX_SLOTS) {
-            memset(scratchPSRAM[slot], 0, szPSRAM * sizeof(float));
-            memset(scratchDRAM[slot], 0, szDRAM * sizeof(float));
+    // Runtime slots: the effect and its knobs, picked up by process() at the next block,
+    // the same way patch slots follow RDX_Common::effects[]
+    inline void setSlotParams(uint8_t slot, FX_ID id, uint8_t p1, uint8_t p2) {
+        if (slot < FX_PATCH_SLOTS || slot >= FX_SLOTS) return;
+        slot_[slot].params[1] = p1;
+        slot_[slot].params[2] = p2;
+        slot_[slot].params[0] = id;
+    }
+
+    // key signal for the envelope driven effects (touch-wah), nullptr to follow the bus again
+    inline void setSidechain(const float* left, const float* right) {
+        scL_ = left;
+        scR_ = left ? right : nullptr;
+        for (int s = 0; s < FX_SLOTS; ++s) {
+            if (slot_[s].fx) slot_[s].fx->setSidechain(scL_, scR_);
         }
     }
 
-    inline void setSlot(uint8_t slot, FX_ID id) {
-        if (slot >= FX_SLOTS || id >= FX_COUNT) return;
-        resetSlot(slot);
-        slots_[slot] = getInstance(id, slot);
-        slots_[slot]->enable(false);
-        slots_[slot]->reset();
-        slots_[slot]->enable(true);
-        fx_[slot] = id;
-        ESP_LOGI("FXHost", "Slot %d -> FX %d", slot, id);
+    inline void setTempo(float bpm, uint8_t div) {
+        bpm_ = bpm;
+        tempoDiv_ = div;
+        for (int s = 0; s < FX_SLOTS; ++s) {
+            if (slot_[s].fx) slot_[s].fx->setTempo(bpm_, tempoDiv_);
+        }
     }
 
-    inline FXBase* getSlot(uint8_t slot) { return slots_[slot]; }
+    inline FXBase* getSlot(uint8_t slot) { return slot < FX_SLOTS ? slot_[slot].fx : nullptr; }
+    inline FX_ID getSlotId(uint8_t slot) const { return slot < FX_SLOTS ? slot_[slot].id : FX_THRU; }
+    // what the slot follows: [0] effect, [1..2] knobs
+    inline const uint8_t* getSlotParams(uint8_t slot) const { return slot < FX_SLOTS ? slot_[slot].src : nullptr; }
+    inline FX_Route getRoute(uint8_t slot) const { return slot < FX_SLOTS ? slot_[slot].route : FX_ROUTE_SERIAL; }
+    inline float getSend(uint8_t slot) const { return slot < FX_SLOTS ? slot_[slot].send : 0.0f; }
+    inline int getFxTime() const { return fxTime_; }
+    inline int getCpuBudget() const { return cpuBudget_; }
+    inline uint32_t getBlockLen() const { return blockLen_; }
 
 private:
 
-    int szDRAM = 0;
-    int szPSRAM = 0; 
-    float* scratchDRAM[2] = {nullptr, nullptr};
-    float* scratchPSRAM[2] = {nullptr, nullptr};
+    struct FxSlot {
+        alignas(8) uint8_t storage[FX_POOL_OBJ_SIZE];
+        FXBase* fx = nullptr;
+        FX_ID id = FX_THRU;
+        uint8_t rejected = 0xFF;    // patch value we failed to load, not retried every block
+        FX_Route route = FX_ROUTE_SERIAL;
+        float send = 1.0f;
+        uint8_t params[3] = {FX_THRU, 64, 64};
+        const uint8_t* src = params;
+        float* fast = nullptr;
+        uint32_t fastCap = 0;
+        float* slow = nullptr;
+        uint32_t slowCap = 0;
+    };
+
+    RDX_Common& common_ = RDX_State::getState().workingPatch().common ;
+    const RDX_Part* parts_ = RDX_State::getState().parts;
+    const RDX_Controls& ctl_ = RDX_State::getState().controls;
 
-    RDX_Common& common_ = RDX_State::getState().workingPatch.common ;
+    // a single voice is enough only when every part playing is mono
+    inline bool anyPolyPart() const {
+        for (int p = 0; p < RDX_PARTS; ++p) {
+            if (parts_[p].enabled && parts_[p].patch.common.monoPoly == RDX_MODE_POLY) return true;
+        }
+        return false;
+    }
     float sampleRate_ = FX_SAMPLE_RATE;
-    uint8_t fx_[2]={0,0};
-    FXBase* slots_[FX_SLOTS] = {nullptr, nullptr};
-
-    // Two copies per effect type  -> static pool
-    FxThru      thru_[FX_SLOTS];
-    FxDistortion distortion_[FX_SLOTS];
-    FxTouchWah  touchwah_[FX_SLOTS];
-    FxChorus    chorus_[FX_SLOTS];
-    FxFlanger   flanger_[FX_SLOTS];
-    FxPhaser    phaser_[FX_SLOTS];
-    FxDelay     delay_[FX_SLOTS];
-    FxReverb    reverb_[FX_SLOTS];
+    FxSlot slot_[FX_SLOTS];
+
+    float tapL_[FX_BLOCK_SIZE];
+    float tapR_[FX_BLOCK_SIZE];
+    float retL_[FX_BLOCK_SIZE];
+    float retR_[FX_BLOCK_SIZE];
 
+    const float* scL_ = nullptr;
+    const float* scR_ = nullptr;
+    float bpm_ = 120.0f;
+    uint8_t tempoDiv_ = 255;
+
+    uint32_t dramUsed_ = 0;
+    uint32_t psramUsed_ = 0;
+    int fxTime_ = 0;
+    int cpuBudget_ = 0;
     int timing[FX_COUNT] = {0} ;
     int voice_timing = 340;
+    static constexpr float UNISON_LAYER_COST = 0.6f;   // share of voice_timing each extra layer adds
+    uint32_t blockLen_ = DMA_BUFFER_LEN;
+    float blockUs_ = 1e+06f * DMA_BUFFER_LEN / FX_SAMPLE_RATE;
+    float timeScale_ = (float)DMA_BUFFER_LEN / (float)FX_TIMING_BLOCK;
 
-
-    inline FXBase* getInstance(FX_ID id, uint8_t slot) {
+    inline FXBase* create(FxSlot& sl, FX_ID id) {
+        void* p = sl.storage;
         switch (id) {
-            case FX_THRU:       return &thru_[slot];
-            case FX_DISTORTION: return &distortion_[slot];
-            case FX_TOUCHWAH:   return &touchwah_[slot];
-            case FX_CHORUS:     return &chorus_[slot];
-            case FX_FLANGER:    return &flanger_[slot];
-            case FX_PHASER:     return &phaser_[slot];
-            case FX_DELAY:      return &delay_[slot];
-            case FX_REVERB:     return &reverb_[slot];
-            default:            return &thru_[slot];
+            case FX_DISTORTION: sl.fx = new (p) FxDistortion(); break;
+            case FX_TOUCHWAH:   sl.fx = new (p) FxTouchWah();   break;
+            case FX_CHORUS:     sl.fx = new (p) FxChorus();     break;
+            case FX_FLANGER:    sl.fx = new (p) FxFlanger();    break;
+            case FX_PHASER:     sl.fx = new (p) FxPhaser();     break;
+            case FX_DELAY:      sl.fx = new (p) FxDelay();      break;
+            case FX_REVERB:     sl.fx = new (p) FxReverb();     break;
+            default:            sl.fx = new (p) FxThru();       break;
         }
+        return sl.fx;
+    }
+
+    inline void destroy(FxSlot& sl) {
+        if (sl.fx) sl.fx->~FXBase();
+        sl.fx = nullptr;
+    }
+
+    inline bool reject(uint8_t slot, FX_ID id) {
+        FxSlot& sl = slot_[slot];
+        if (sl.id != FX_THRU || !sl.fx) {
+            destroy(sl);
+            create(sl, FX_THRU)->bindParams(sl.src);
+            fxTime_ -= timing[sl.id];
+            sl.id = FX_THRU;
+        }
+        sl.rejected = id;
+        return false;
+    }
+
+    // Every slot gets scratch for the hungriest effect once, so changing effects never touches
+    // the heap in the audio task. Slots are served in order while the budgets last: the patch
+    // slots can take any effect, a runtime slot past the budget only the ones that fit it.
+    inline void allocScratch() {
+        uint32_t fastMax = 0, slowMax = 0;
+        for (int id = FX_THRU; id < FX_COUNT; ++id) {
+            FxSlot& sl = slot_[0];
+            destroy(sl);
+            FXBase* fx = create(sl, (FX_ID)id);
+            fastMax = max(fastMax, fx->fastScratchNeeded(sampleRate_));
+            slowMax = max(slowMax, fx->slowScratchNeeded(sampleRate_));
+            destroy(sl);
+        }
+        for (int s = 0; s < FX_SLOTS; ++s) {
+            FxSlot& sl = slot_[s];
+            if (!sl.fast) sl.fast = alloc(sl.fastCap, fastMax, dramUsed_, FX_DRAM_BUDGET, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (!sl.slow) sl.slow = alloc(sl.slowCap, slowMax, psramUsed_, FX_PSRAM_BUDGET, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            ESP_LOGI("FXHost", "Slot %d scratch: fast %d of %d, slow %d of %d floats", s, sl.fastCap, fastMax, sl.slowCap, slowMax);
+        }
+    }
+
+    // up to need floats, as many as the budget leaves
+    static inline float* alloc(uint32_t& cap, uint32_t need, uint32_t& used, uint32_t budget, uint32_t caps) {
+        cap = 0;
+        const uint32_t n = min(need, (budget - used) / (uint32_t)sizeof(float));
+        if (!n) return nullptr;
+        float* p = (float*) heap_caps_malloc(n * sizeof(float), caps);
+        if (!p) return nullptr;
+        used += n * sizeof(float);
+        cap = n;
+        return p;
     }
 };
@@ -32,61 +32,237 @@ SH1106_Display display;
 #include "src/GUI/UI_Algos.h"
 #include "src/GUI/RDX_Sliders.h"
 #include "src/GUI/RDX_Graph.h"
+#include "src/GUI/RDX_Scope.h"
+#include "src/GUI/UI_Manager.h"
+#include "src/GUI/UI_InputDefs.h"
+#include "src/GUI/RDX_ParamPages.h"
+#include "src/GUI/RDX_Browser.h"
 
 
 #include "RDX_PresetManager.h"
 extern PresetManager pm;
 
+#if RDX_AUDIO_TAP
+#include "RDX_AudioTap.h"
+extern RDX_AudioTap tap;
+#endif
+
+enum RDX_GuiPage : uint8_t {
+    GUI_PAGE_PATCH = 0,
+    GUI_PAGE_BROWSER,
+    GUI_PAGE_COMMON,
+    GUI_PAGE_PEG,
+    GUI_PAGE_FX,
+    GUI_PAGE_OP1,
+    GUI_PAGE_OP2,
+    GUI_PAGE_OP3,
+    GUI_PAGE_OP4,
+    GUI_PAGE_SCOPE,     // needs RDX_AUDIO_TAP
+    GUI_PAGE_COUNT
+};
+
+
+// ---------------- home page: bank, name, algorithm ----------------
+class RDX_BankWidget : public UI_Widget {
+  public:
+    RDX_BankWidget() : UI_Widget(0, 0, 80, 8) {}
+    void draw(UI_Display& d) override {
+      char t[16];
+      snprintf(t, sizeof(t), "Bank %d-%d", (idx_ - 1) / 8 + 1, (idx_ - 1) % 8 + 1);
+      d.drawText(2, 0, t);
+    }
+  protected:
+    bool poll() override {
+      const int i = pm.currentIndex();
+      if (i == idx_) return false;
+      idx_ = i;
+      return true;
+    }
+  private:
+    int idx_ = -1;
+};
+
+class RDX_NameWidget : public UI_Widget {
+  public:
+    RDX_NameWidget() : UI_Widget(0, 8, 128, 20) {}
+    void draw(UI_Display& d) override {
+      d.setTextScale(UITextScale::X2);
+      d.drawTextBytes(4, 10, name_, 10);
+    }
+  protected:
+    bool poll() override {
+      const uint8_t* n = RDX_State::getState().workingPatch().common.voiceName;
+      if (!memcmp(n, name_, 10)) return false;
+      memcpy(name_, n, 10);
+      return true;
+    }
+  private:
+    uint8_t name_[10] = {0xFF};
+};
+
+class RDX_AlgoWidget : public UI_Widget {
+  public:
+    RDX_AlgoWidget() : UI_Widget(0, 28, 128, 36) {}
+    void draw(UI_Display& d) override {
+      d.setBrush(UIDisplayBrush::DOTTED);
+      d.drawHLine(0, 28, 128);
+      drawAlgo(d, 29, algo_, 35, true);
+    }
+  protected:
+    bool poll() override {
+      const uint8_t a = RDX_State::getState().workingPatch().common.algorithm;
+      if (a == algo_) return false;
+      algo_ = a;
+      return true;
+    }
+  private:
+    uint8_t algo_ = 0xFF;
+};
+
+class RDX_HomePage : public UI_Page {
+  public:
+    RDX_HomePage() {
+      add(&bank_);
+      add(&name_);
+      add(&algo_);
+    }
+  private:
+    RDX_BankWidget bank_;
+    RDX_NameWidget name_;
+    RDX_AlgoWidget algo_;
+};
+
+#if RDX_AUDIO_TAP
+// ---------------- scope page: whole screen on a frame clock while the tap has new audio ----------------
+class RDX_ScopePage : public UI_Page {
+  public:
+    static constexpr int      SCOPE_FFT     = 128;
+    static constexpr uint32_t SCOPE_FRAME_MS = 40;
+
+    void onEnter() override { force_ = true; }
+
+    bool draw(UI_Display& d) override {
+      const uint32_t now = millis();
+      if (!force_ && (now - lastFrameMs_ < SCOPE_FRAME_MS || tap.position() == lastTapPos_)) return false;
+      lastFrameMs_ = now;
+      lastTapPos_ = tap.position();
+      force_ = false;
+
+      if (!tap.snapshot(scopeBuf_, SCOPE_FFT * 2)) return false;   // lapped, next frame
+      fft_.magnitudes(scopeBuf_ + SCOPE_FFT, fftMag_);
+
+      float levels[MAX_VOICES];
+      const int nv = VOICES < MAX_VOICES ? VOICES : MAX_VOICES;
+      for (int v = 0; v < nv; ++v) levels[v] = tap.voiceLevel(v);
+
+      d.clear();
+      drawScope(d, 0, 0, 128, 32, scopeBuf_, SCOPE_FFT * 2);
+      drawSpectrum(d, 0, 34, 96, 21, fftMag_, 48);
+      drawVoiceBars(d, 100, 34, 28, 21, levels, nv);
+      drawMeter(d, 0, 57, 128, 3, tap.rmsL(), tap.takePeakL());
+      drawMeter(d, 0, 61, 128, 3, tap.rmsR(), tap.takePeakR());
+      return true;
+    }
+
+  private:
+    UI_FFT<SCOPE_FFT>   fft_;
+    int16_t             scopeBuf_[SCOPE_FFT * 2];
+    uint16_t            fftMag_[SCOPE_FFT / 2];
+    uint32_t            lastFrameMs_ = 0;
+    uint32_t            lastTapPos_ = 0;
+    bool                force_ = true;
+};
+#endif
 
+
+// Pages are switched and edited from the control task through input(), the GUI task
+// handles it in draw() and sends only the widgets that changed.
 class RDX_GUI {
   public:
     RDX_GUI () {};
     
-    inline void begin() { display.begin(); }
+    inline void begin() {
+      display.begin();
+      ui_.setDisplay(&display);
+      ui_.bindPage(GUI_PAGE_PATCH, &home_);
+      browser_.setIndex(&pm.index());
+      ui_.bindPage(GUI_PAGE_BROWSER, &browser_);
+      ui_.bindPage(GUI_PAGE_COMMON, &common_);
+      ui_.bindPage(GUI_PAGE_PEG, &peg_);
+      ui_.bindPage(GUI_PAGE_FX, &fx_);
+      for (int i = 0; i < 4; ++i) {
+        ops_[i].addGraph(&opEG_[i]);
+        ui_.bindPage(GUI_PAGE_OP1 + i, &ops_[i]);
+      }
+      peg_.addGraph(&pegEG_);
+#if RDX_AUDIO_TAP
+      ui_.bindPage(GUI_PAGE_SCOPE, &scope_);
+#endif
+      ui_.setPage(GUI_PAGE_PATCH);
+    }
 
     inline void draw() {
       if (updateCounter_ > 0) {
         updateCounter_--;
         return;
       } 
-      if(!needUpdate_) return;
-
-      display.clear();
-      display.setColor(UIDisplayColor::WHITE);
-      display.setBrush(UIDisplayBrush::SOLID);
-      display.setTextScale(UITextScale::X2);
-      display.drawTextBytes(4, 10, patch_.common.voiceName, 10);
-
-      display.setTextScale(UITextScale::X1);
-      display.drawText(2, 0, "Bank  -");
-
-      uint8_t m, l;
-      m = (pm.currentIndex()-1) / 8 + 1;
-      l = (pm.currentIndex()-1) % 8 + 1;
-      char t[5];
-      snprintf(t, sizeof(t), "%d", m);
-      display.drawText(2 + 6 * 5, 0, t);
-      snprintf(t, sizeof(t), "%d", l);
-      display.drawText(2 + 6 * 7, 0, t);
-
-      display.setBrush(UIDisplayBrush::DOTTED);
-      display.drawHLine(0, 28, 128);
-
-      drawAlgo(display, 29,  patch_.common.algorithm, 35, true);
-      display.update();
-      needUpdate_ = false;
+      const uint8_t want = wantPage_.exchange(NO_PAGE, std::memory_order_acquire);
+      if (want != NO_PAGE) ui_.setPage(want);
+      if (needUpdate_) {
+        needUpdate_ = false;
+        ui_.redraw();
+      }
+      ui_.draw();
     }
 
+    // full redraw, widgets follow the patch on their own
     inline void push() { needUpdate_ = true; }
 
     inline void pause(int32_t n) { updateCounter_ = n; }
 
+    // any task
+    inline void input(UIInputType type, uint8_t id, int16_t value) {
+      UIInputEvent ev;
+      ev.type = type;
+      ev.id = id;
+      ev.value = value;
+      ui_.postInput(ev);
+    }
+    inline void setPage(RDX_GuiPage p) { wantPage_.store(p, std::memory_order_release); }
+    inline void nextPage() { input(UIInputType::PAGE, 0, 1); }
+    inline RDX_GuiPage page() const { return (RDX_GuiPage)ui_.pageId(); }
+
   private:
-  
-    RDX_Patch&          patch_          = RDX_State::getState().workingPatch; 
+    static constexpr uint8_t NO_PAGE = 0xFF;
+
+    static constexpr int EG_X = 86;     // op/PEG pages: list on the left, EG on the right
+    static constexpr int LIST_W = EG_X - 2;
+
+    UI_Manager          ui_;
+    RDX_HomePage        home_;
+    RDX_BrowserPage     browser_;
+    RDX_ParamPage       common_ {"COMMON", COMMON_PARAMS, sizeof(COMMON_PARAMS) / sizeof(COMMON_PARAMS[0])};
+    RDX_ParamPage       peg_    {"PITCH EG", PEG_PARAMS, sizeof(PEG_PARAMS) / sizeof(PEG_PARAMS[0]), -1, LIST_W};
+    RDX_ParamPage       fx_     {"EFFECTS", FX_PARAMS, sizeof(FX_PARAMS) / sizeof(FX_PARAMS[0])};
+    RDX_ParamPage       ops_[4] {
+      {"OP1", OP_PARAMS, sizeof(OP_PARAMS) / sizeof(OP_PARAMS[0]), 0, LIST_W},
+      {"OP2", OP_PARAMS, sizeof(OP_PARAMS) / sizeof(OP_PARAMS[0]), 1, LIST_W},
+      {"OP3", OP_PARAMS, sizeof(OP_PARAMS) / sizeof(OP_PARAMS[0]), 2, LIST_W},
+      {"OP4", OP_PARAMS, sizeof(OP_PARAMS) / sizeof(OP_PARAMS[0]), 3, LIST_W}
+    };
+    RDX_EGWidget        pegEG_  {-1, EG_X, 12, 128 - EG_X, 40};
+    RDX_EGWidget        opEG_[4] {
+      {0, EG_X, 12, 128 - EG_X, 40}, {1, EG_X, 12, 128 - EG_X, 40},
+      {2, EG_X, 12, 128 - EG_X, 40}, {3, EG_X, 12, 128 - EG_X, 40}
+    };
+#if RDX_AUDIO_TAP
+    RDX_ScopePage       scope_;
+#endif
+
+    std::atomic<uint8_t> wantPage_{NO_PAGE};
     bool needUpdate_ = false;
     int32_t updateCounter_ = 0; 
 
 };
 
-#endif //ENABLE_GUI
\ No newline at end of file
+#endif //ENABLE_GUI
\ No newline at end of file
@@ -36,24 +36,35 @@ public:
         delaySamples_ = delay_ * SAMPLE_RATE;
         fadeInSamples_ = delaySamples_ / 3;
         fadeInIncrement_ = (fadeInSamples_ > 0)
-                               ? (float)DMA_BUFFER_LEN / (float)fadeInSamples_
+                               ? 1.0f / (float)fadeInSamples_
                                : 1.0f;
     }
 
     inline void setRate(uint8_t rate) {
         if (rate > 127) rate = 127;
         frequency_ = LFO_SPEED[rate];
-        phaseInc_ = frequency_ * DMA_BUFFER_LEN * DIV_SAMPLE_RATE;
+        phaseInc_ = frequency_ * DIV_SAMPLE_RATE;
     }
 
     inline void setWaveform(Waveform wf) { waveform_ = wf; }
 
-    // --- call once per audio block ---
-    inline void updateState() {
+    // Tempo sync: phase follows the beat position, so the LFO can't drift against the clock.
+    // Call before updateState() every block, unsync() goes back to the rate set by setRate().
+    inline void syncTo(double beat, float beatsPerSample, float beatsPerCycle) {
+        const double cycles = beat / beatsPerCycle;
+        phase_ = (float)(cycles - floor(cycles));
+        syncInc_ = beatsPerSample / beatsPerCycle;
+        synced_ = true;
+    }
+
+    inline void unsync() { synced_ = false; }
+
+    // --- call once per audio block of n samples ---
+    inline void updateState(uint32_t n = DMA_BUFFER_LEN) {
         // --- delay / fade-in ---
         if (delaySamples_ > 0) {
-            delaySamples_ -= DMA_BUFFER_LEN;
-            fadeInEnv_ += fadeInIncrement_;
+            delaySamples_ -= n;
+            fadeInEnv_ += fadeInIncrement_ * n;
             if (fadeInEnv_ >= 1.f) {
                 fadeInEnv_ = 1.f;
                 delaySamples_ = 0;
@@ -61,7 +72,7 @@ public:
         }
 
         float startPhase = phase_;
-        float endPhase = startPhase + phaseInc_;
+        float endPhase = startPhase + (synced_ ? syncInc_ : phaseInc_) * n;
         if (endPhase >= 1.f) endPhase -= fast_floorf(endPhase);
 
         // --- Sample & Hold 8-step ---
@@ -99,7 +110,7 @@ public:
             increment_ = 0.f;
         } else {
             value_ = v0 * fadeInEnv_;
-            increment_ = (v1 - v0) / float(DMA_BUFFER_LEN);
+            increment_ = (v1 - v0) / float(n);
         }
 
         prevValue_ = v1;
@@ -153,7 +164,9 @@ private:
     float prevValue_ = 0.f;
     float increment_ = 0.f;
 
-    float phaseInc_ = 0.f; // cycles per block
+    float phaseInc_ = 0.f; // cycles per sample
+    float syncInc_ = 0.f;  // same, while tempo synced
+    bool  synced_ = false;
 
     // S&H
     float shValue_ = 0.f;
@@ -4,10 +4,12 @@
 #include <MIDI.h> 
 #include "RDX_State.h" // for RDX_State::getState()
 #include "RDX_Synth.h"
+#include "RDX_Sysex.h"
 #include "RDX_GUI.h"
 
 
 extern RDX_Synth synth;   // defined in RDX.ino
+extern TaskHandle_t midiTaskHandle;
 
 #ifdef ENABLE_GUI
 extern RDX_GUI gui;
@@ -27,10 +29,97 @@ constexpr uint32_t SYSEX_BUF_SIZE = 512;
 uint8_t syxBuf[SYSEX_BUF_SIZE];
 uint32_t syxLen = 0;
 
+RDX_SysexBulk syxBulk;
+
+#include "RDX_MidiClock.h"
+RDX_MidiClock midiClock;
+
+// -----------------------------
+// CC / pitch bend coalescing
+// Continuous controllers arriving in one burst are held back and only the last value
+// per controller is applied. Anything order-sensitive (notes, switches, program, SysEx)
+// flushes them first, so the resulting state is the same as handling every message.
+// -----------------------------
+struct PendingCC { uint8_t ch, cc, val; };
+PendingCC pendingCC[MIDI_COALESCE_SLOTS];
+uint32_t pendingCCNum = 0;
+int pendingPB[16];
+uint16_t pendingPBMask = 0;
+
+inline bool ccCoalescable(uint8_t cc) {
+    // bank select, switches/pedals, data entry and channel mode messages keep their order
+    return !(cc == 0 || cc == 32 || cc == 6 || cc == 38 || (cc >= 64 && cc <= 69) || (cc >= 96 && cc <= 101) || cc >= 120);
+}
+
+inline void flushPendingControls() {
+    if (pendingPBMask) {
+        for (uint8_t ch = 0; ch < 16; ++ch) {
+            if (pendingPBMask & (1 << ch)) synth.updatePB(ch + 1, pendingPB[ch]);
+        }
+        pendingPBMask = 0;
+    }
+    for (uint32_t i = 0; i < pendingCCNum; ++i) {
+        synth.processCC(pendingCC[i].ch, pendingCC[i].cc, pendingCC[i].val);
+    }
+    pendingCCNum = 0;
+}
+
+inline void queueCC(uint8_t channel, uint8_t cc, uint8_t val) {
+    for (uint32_t i = 0; i < pendingCCNum; ++i) {
+        if (pendingCC[i].cc == cc && pendingCC[i].ch == channel) {
+            pendingCC[i].val = val;
+            return;
+        }
+    }
+    if (pendingCCNum >= MIDI_COALESCE_SLOTS) flushPendingControls();
+    pendingCC[pendingCCNum++] = {channel, cc, val};
+}
+
+// -----------------------------
+// NRPN: synth setup that isn't part of a Reface DX patch.
+// CC99/98 pick the parameter, CC6 sets it, on any channel.
+//  MSB 0x70+p  part p:     LSB 0 on/off, 1 channel (0..15, 16 = omni), 2 key low, 3 key high,
+//                          4 volume, 5 reserved voices, 6 note priority (RDX_NotePriority)
+//  MSB 0x74+s  FX slot s:  LSB 0 effect (FX_ID), 1/2 knobs, runtime slots only, patch slots
+//                          follow the patch; 3 route (FX_Route), 4 send 0..127
+//  MSB 0x7C    system:     LSB 0 LFO sync, 1 delay sync (RDX_TempoDiv, 127 = free),
+//                          2 audio block length / 16, 3 DMA buffers
+// -----------------------------
+constexpr uint8_t NRPN_PART   = 0x70;
+constexpr uint8_t NRPN_FX     = 0x74;
+constexpr uint8_t NRPN_SYSTEM = 0x7C;
+
+void rdxSetNrpn(uint8_t msb, uint8_t lsb, uint8_t val);   // RDX.ino
+
+uint8_t nrpnMSB = 0x7F;     // 0x7F/0x7F = none, also after an RPN select
+uint8_t nrpnLSB = 0x7F;
+
+// true if the CC was an NRPN select or data entry
+inline bool handleNrpn(uint8_t cc, uint8_t val) {
+    switch (cc) {
+        case 99:  nrpnMSB = val; return true;
+        case 98:  nrpnLSB = val; return true;
+        case 101:
+        case 100: nrpnMSB = nrpnLSB = 0x7F; return false;
+        case 6:
+            if (nrpnMSB == 0x7F && nrpnLSB == 0x7F) return false;
+            rdxSetNrpn(nrpnMSB, nrpnLSB, val);
+            return true;
+        case 38:  return nrpnMSB != 0x7F || nrpnLSB != 0x7F;   // 7-bit values, the LSB is dropped
+        default:  return false;
+    }
+}
+
+// driver hooks (USB task / UART event task): wake the MIDI task
+inline void midiNotify() {
+    if (midiTaskHandle) xTaskNotifyGive(midiTaskHandle);
+}
+
 // -----------------------------
 // Bulk dump helpers
 // -----------------------------
 inline void dumpSysex(const uint8_t* buf, uint32_t len, const char* tag = "SYSEX") {
+#if SYSEX_DEBUG
     ESP_LOGD(tag, "SysEx (%u bytes):", len);
     char line[128];
     uint32_t pos = 0;
@@ -42,6 +131,9 @@ inline void dumpSysex(const uint8_t* buf, uint32_t len, const char* tag = "SYSEX
             pos = 0;
         }
     }
+#else
+    (void)buf; (void)len; (void)tag;
+#endif
 }
 
 
@@ -184,6 +276,7 @@ void handleAll(const midi::MidiInterface<usbMidi::usbMidiTransport>::MidiMessage
 }
 
 inline void handleSysEx(byte* data, unsigned length) {
+    flushPendingControls();
     dumpSysex( data, length, "SYSEX IN");
     if (length < 6 || data[0] != 0xF0 || data[length - 1] != 0xF7) return;
 
@@ -215,10 +308,10 @@ inline void handleSysEx(byte* data, unsigned length) {
         uint8_t val = data[9];
         if (addrH == 0x30) {
             ESP_LOGD("IN", "Common param change: offset=0x%02X val=%d", addrL, val);
-            applyCommonParam(synth.currentPatch(), addrL, val);
+            synth.setCommonParam(addrL, val);
         } else if (addrH == 0x31) {
             ESP_LOGD("IN", "Operator %d param change: offset=0x%02X val=%d", addrM, addrL, val);
-            applyOperatorParam(synth.currentPatch(), addrM, addrL, val);
+            synth.setOperatorParam(addrM, addrL, val);
         } else {
             ESP_LOGI("IN", "Unknown param change at addr=%02X%02X%02X", addrH, addrM, addrL);
         }
@@ -230,9 +323,26 @@ inline void handleSysEx(byte* data, unsigned length) {
     // ===================================================
     case 0x0: { // BULK DUMP (editor → us)
     // ===================================================
-        ESP_LOGI("IN", "BulkDump received (%u bytes)", length);
-        // ModelID is data[7], Address is data[8..10], Data starts at [11]
-        // Here you’d call unpackCommonBlock/unpackOperatorBlock depending on addrH
+        // blocks are staged one message at a time, the voice goes live on the footer
+        switch (syxBulk.feed(data, length)) {
+            case RDX_SysexBulk::SYX_PATCH: {
+                char name[11] = {0};
+                memcpy(name, syxBulk.patch().common.voiceName, 10);
+                ESP_LOGI("IN", "BulkDump voice '%s'", name);
+                synth.applyPatch(syxBulk.patch());
+                return; // applyPatch() notifies the GUI
+            }
+            case RDX_SysexBulk::SYX_SYSTEM:
+                ESP_LOGI("IN", "BulkDump system block");
+                RDX_State::getState().system = syxBulk.system();
+                break;
+            case RDX_SysexBulk::SYX_ERROR:
+                // bulk address sits after the byte count and model ID
+                ESP_LOGW("IN", "BulkDump block rejected addr=%02X%02X%02X", length > 10 ? data[8] : 0, length > 10 ? data[9] : 0, length > 10 ? data[10] : 0);
+                return;
+            default:
+                return; // header or a staged block, nothing to show yet
+        }
         break;
     }
 
@@ -277,7 +387,8 @@ void handleNoteOn(uint8_t channel, uint8_t note, uint8_t velocity) {
     gui.pause(20);
 #endif
     ESP_LOGD("MIDI", "Note on %d %d", note, velocity);
-    synth.noteOn(note, velocity);
+    flushPendingControls();
+    synth.noteOn(note, velocity, channel);
 
     // Forward to Soundmondo / external MIDI
 //    MIDI.sendNoteOn(note, velocity, channel);
@@ -287,7 +398,8 @@ void handleNoteOff(uint8_t channel, uint8_t note, uint8_t velocity) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
-    synth.noteOff(note);
+    flushPendingControls();
+    synth.noteOff(note, channel);
  
 }
 
@@ -295,23 +407,43 @@ void handleCC(uint8_t channel, uint8_t cc, uint8_t val) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
-    synth.processCC(channel, cc, val);
+    if (ccCoalescable(cc)) {
+        queueCC(channel, cc, val);
+    } else {
+        flushPendingControls();
+        if (!handleNrpn(cc, val)) synth.processCC(channel, cc, val);
+    }
 }
 
 void handlePB(uint8_t channel, int pb) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
-    synth.updatePB(channel, pb);
+    const uint8_t ch = (channel - 1) & 0x0F;
+    pendingPB[ch] = pb;
+    pendingPBMask |= 1 << ch;
 }
 
 void handleProgChange(uint8_t channel, uint8_t pr) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
+    flushPendingControls();
     synth.programChange(channel, pr);
 }
 
+// -----------------------------
+// MIDI clock: 0xF8 is stamped with the audio sample position, the audio task does the rest
+// -----------------------------
+void handleClock() {
+    const SynthState& st = RDX_State::getState();
+    midiClock.externalTick(st.transport.stamp(micros(), st.audio.blockLen));
+}
+
+void handleStart()    { midiClock.startSync(); }
+void handleStop()     { midiClock.stopSync(); }
+void handleContinue() { midiClock.continueSync(); }
+
 void setupMidi() {
 #if MIDI_IN_DEV == USE_USB_MIDI_DEVICE
   // Change USB Device Descriptor Parameter
@@ -332,8 +464,24 @@ void setupMidi() {
     MIDI.setHandlePitchBend(handlePB);
     MIDI.setHandleProgramChange(handleProgChange);    
     MIDI.setHandleSystemExclusive(handleSysEx);
+    MIDI.setHandleClock(handleClock);
+    MIDI.setHandleStart(handleStart);
+    MIDI.setHandleStop(handleStop);
+    MIDI.setHandleContinue(handleContinue);
+    midiClock.setSampleRate(SAMPLE_RATE);
+#if MIDI_CLOCK_SYNC
+    midiClock.begin(MidiClock::SYNC_AUDIO_EXT, 96, MIDI_CLOCK_BPM);
+    midiClock.enableOut(false);
+#else
+    midiClock.begin(MidiClock::SYNC_AUDIO, 96, MIDI_CLOCK_BPM);
+#endif
   //  MIDI.setHandleMessage(handleAll);
     MIDI.begin(MIDI_CHANNEL_OMNI);
+#if MIDI_IN_DEV == USE_USB_MIDI_DEVICE
+    MidiUSB.onReceive(midiNotify);
+#elif MIDI_IN_DEV == USE_MIDI_STANDARD
+    Serial1.onReceive(midiNotify);
+#endif
     delay(800);
 }
 
@@ -348,8 +496,22 @@ void keepAlive() {
 }
 
 
+// bytes still waiting in the transport (a message may span several read() calls)
+inline bool midiPending() {
+#if MIDI_IN_DEV == USE_USB_MIDI_DEVICE
+    return __usbMIDI.available() > 0;
+#else
+    return Serial1.available() > 0;
+#endif
+}
+
+// drains everything the transport holds, then applies the coalesced controllers
 inline void processMidi() {
-    MIDI.read();
+    for (int n = 0; n < MIDI_DRAIN_MAX; ++n) {
+        if (!MIDI.read() && !midiPending()) break;
+    }
+    flushPendingControls();
+    midiClock.flushOut();
     //keepAlive();
 }
 
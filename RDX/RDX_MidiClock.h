@@ -1,10 +1,11 @@
 // RDX_MidiClock.h
 #pragma once
+#include <atomic>
 #include "MidiClock.h"
 #include "MIDI.h"   // fortyseveneffects MIDI lib
 
-extern midi::MidiInterface<midi::SerialMIDI<HardwareSerial>> MIDI;
-
+// Included by RDX_Midi.h after the MIDI instance is created.
+// Ticks are produced in the audio task, the MIDI task sends them with flushOut().
 class RDX_MidiClock : public MidiClock {
 public:
     void enableOut(bool enabled) { sendOut_ = enabled; }
@@ -12,12 +13,19 @@ public:
 protected:
     void produceTick() override {
         MidiClock::produceTick();
-        if (sendOut_) {
-            MIDI.sendRealTime(midi::Clock); // 0xF8
+        const uint8_t div = getPPQN() / 24;
+        if (sendOut_ && (div < 2 || getTickCount() % div == 0)) {
+            pendingOut_.fetch_add(1, std::memory_order_relaxed); // 0xF8 at 24 ppqn
         }
     }
 
 public:
+    // MIDI task
+    void flushOut() {
+        uint16_t n = pendingOut_.exchange(0, std::memory_order_relaxed);
+        while (n--) MIDI.sendRealTime(midi::Clock);
+    }
+
     void sendStart() {
         if (sendOut_) MIDI.sendRealTime(midi::Start);
     }
@@ -32,4 +40,5 @@ public:
 
 private:
     bool sendOut_ = true;
+    std::atomic<uint16_t> pendingOut_{0};
 };
@@ -12,43 +12,82 @@
 // RDX Operator (float-domain, uses RDX_GAIN)
 // ===============================
 class  IRAM_ATTR __attribute__((always_inline)) RDX_Operator {
+    // oscillator state of one unison layer, everything else is shared by the stack
+    struct Osc {
+        float phase       = 0.0f;   // normalized [0..1)
+        float fbAcc       = 0.0f;   // last output for feedback
+        float fbFilter    = 0.0f;   // LPF state
+        float osHist[5]   = {0.f};  // 2x-rate outputs, newest first
+        float osLastInput = 0.f;
+        float inc         = 0.f;    // effective phase increment, set at control rate
+        float dInc        = 0.f;    // its per-sample slope while the pitch is moving
+    };
+
 public:
     RDX_Operator(int idx)
         : idx_(idx),
-          params_(RDX_State::getState().workingPatch.ops[idx]) {}
+          params_(&RDX_State::getState().workingPatch().ops[idx]) {}
+
+    // points the operator at a part's patch, done by the voice at note-on
+    inline void bindParams(RDX_OpParams* p) { params_ = p; }
 
     inline void setParams( int note, int vel, float baseHz) {
+        note_ = note;
+        vel_ = vel;
+        baseHz_ = baseHz;
         setFrequency(baseHz);
 
-        scaling_ = calcScalingFactor( note, params_.scaleLD, (RDX_ScaleCurve)params_.scaleLC,  params_.scaleRD, (RDX_ScaleCurve)params_.scaleRC);
-        velogain_ = velocityGain( vel, params_.velSens, 1.08f);
+        scaling_ = calcScalingFactor( note, params_->scaleLD, (RDX_ScaleCurve)params_->scaleLC,  params_->scaleRD, (RDX_ScaleCurve)params_->scaleRC);
+        velogain_ = velocityGain( vel, params_->velSens, 1.08f);
         
         // Cache OUT LEVEL gain and feedback scale/sign to avoid per-sample table lookups
-        outGain_  = rdxGain(params_.outLevel * velogain_ ) * scaling_;
-        ESP_LOGD("OP", "%d: scaling %f out %f (op level %d velo %d)", idx_, scaling, outGain_, params_.outLevel, vel ) ;
-        env_.initAEG(params_.egRate, params_.egLevel, true);
-
-        fbRectify_ = (params_.fbType != RDX_FB_SAW) ; 
-        fbScale_  = FEEDBACK_K[params_.feedback]   ; 
-        enabled_ = params_.enable;
-        
+        outGain_  = rdxGain(params_->outLevel * velogain_ ) * scaling_;
+        ESP_LOGD("OP", "%d: scaling %f out %f (op level %d velo %d)", idx_, scaling, outGain_, params_->outLevel, vel ) ;
+        env_.initAEG(params_->egRate, params_->egLevel, true);
+
+        fbRectify_ = (params_->fbType != RDX_FB_SAW) ; 
+        fbScale_  = FEEDBACK_K[params_->feedback]   ; 
+        enabled_ = params_->enable;
+        setOversample();
     }
 
     inline void updateParams() {
-        outGain_  = rdxGain(params_.outLevel * velogain_ ) * scaling_;
-        env_.initAEG(params_.egRate, params_.egLevel, false);
-        fbRectify_ = (params_.fbType != RDX_FB_SAW) ; 
-        fbScale_  = FEEDBACK_K[params_.feedback]   ; 
-        enabled_ = params_.enable;
+        applyUpdates(RDX_UPD_OP_ALL);
     }
 
-    inline RDX_OpParams& params() { return params_; }
-    inline const RDX_OpParams& params() const { return params_; }
+    // recomputes only what the changed params feed, see OP_PARAM_UPDATE
+    inline void applyUpdates(uint8_t what) {
+        if (what & RDX_UPD_OP_FREQ) {
+            setFrequency(baseHz_);
+        }
+        if (what & RDX_UPD_OP_SCALE) {
+            scaling_ = calcScalingFactor( note_, params_->scaleLD, (RDX_ScaleCurve)params_->scaleLC,  params_->scaleRD, (RDX_ScaleCurve)params_->scaleRC);
+            velogain_ = velocityGain( vel_, params_->velSens, 1.08f);
+        }
+        if (what & (RDX_UPD_OP_LEVEL | RDX_UPD_OP_SCALE)) {
+            outGain_  = rdxGain(params_->outLevel * velogain_ ) * scaling_;
+        }
+        if (what & RDX_UPD_OP_EG) {
+            env_.initAEG(params_->egRate, params_->egLevel, false);
+        }
+        if (what & RDX_UPD_OP_FB) {
+            fbRectify_ = (params_->fbType != RDX_FB_SAW) ; 
+            fbScale_  = FEEDBACK_K[params_->feedback]   ; 
+            enabled_ = params_->enable;
+            setOversample();
+        }
+    }
+
+    inline RDX_OpParams& params() { return *params_; }
+    inline const RDX_OpParams& params() const { return *params_; }
 
     inline void reset() {
-        phase_    = 0.0f;
-        fbAcc_   = 0.0f;
-        fbFilter_ = 0.f; 
+        for (int l = 0; l < MAX_VOICES_PER_NOTE; ++l) {
+            osc_[l].phase    = l * 0.3183f;   // unison layers don't start in phase
+            osc_[l].fbAcc    = 0.0f;
+            osc_[l].fbFilter = 0.f;
+        }
+        clearOversampleState();
         env_.reset();
     }
 
@@ -58,49 +97,119 @@ public:
 
 
 
-    inline IRAM_ATTR __attribute__((always_inline, hot)) float compute(    float inputPhaseOffset, float phaseModSemitones = 0.f) {
-        if (!params_.enable) return 0.f;
+    // Control rate: modulated pitch as a frequency ratio at the start of the step and its per-sample
+    // slope, folded with the note and the unison detune into each layer's phase increment.
+    inline void setPitch(float ratio, float ratioSlope, int layers) {
+        const float inc = phaseInc_ * ratio;
+        const float dInc = phaseInc_ * ratioSlope;
+        ramping_ = (ratioSlope != 0.f);
+        for (int l = 0; l < layers; ++l) {
+            osc_[l].inc  = inc * layerRatio_[l];
+            osc_[l].dInc = dInc * layerRatio_[l];
+        }
+    }
+
+    // Once per sample before compute(): the envelope, shared by all unison layers. Leaves layer 0 selected.
+    inline IRAM_ATTR __attribute__((always_inline, hot)) void tick() {
+        if (!params_->enable) return;
+        envGain_ = outGain_ * env_.processAEG();
+        cur_ = &osc_[0];
+    }
+
+    inline IRAM_ATTR __attribute__((always_inline)) void selectLayer(int l) {
+        cur_ = &osc_[l];
+    }
+
+    // detune of a unison layer as a frequency ratio
+    inline void setLayerRatio(int l, float ratio) { layerRatio_[l] = ratio; }
+
+    inline IRAM_ATTR __attribute__((always_inline, hot)) float compute(float inputPhaseOffset) {
+        if (!params_->enable) return 0.f;
+#if RDX_FB_OVERSAMPLE
+        if (oversample_) return computeOversampled(inputPhaseOffset);
+#endif
+        Osc& o = *cur_;
 
         // Optional rectification 
-        if (params_.fbType && fbAcc_ < 0.f) fbAcc_ = -fbAcc_;
+        if (params_->fbType && o.fbAcc < 0.f) o.fbAcc = -o.fbAcc;
     
         // Lowpass filter the feedback path
-        fbFilter_ += fbLpCoef_ * (fbAcc_ - fbFilter_);  // 1-pole IIR
+        o.fbFilter += fbLpCoef_ * (o.fbAcc - o.fbFilter);  // 1-pole IIR
 
         // Lookup phase = base + inbus offset + filtered feedback + optional jitter
-        float lookupPhase = wrap01(phase_ + inputPhaseOffset + fbFilter_ * fbScale_ );
+        float lookupPhase = wrap01(o.phase + inputPhaseOffset + o.fbFilter * fbScale_ );
 
         // Advance own oscillator phase by note + PEG/LFO modulation
-        phase_ = (phase_ + phaseInc_ * semitonesToRatio(phaseModSemitones));
-        if(phase_>1.0f) phase_ -= 1.0f;
+        if (ramping_) o.inc += o.dInc;
+        o.phase = (o.phase + o.inc);
+        if(o.phase>1.0f) o.phase -= 1.0f;
 
         // Sine lookup and feedback state update
-        fbAcc_  = sin01(lookupPhase);
+        o.fbAcc  = sin01(lookupPhase);
 
         // Apply gain + AEG
-        return fbAcc_ * outGain_ * env_.processAEG();
+        return o.fbAcc * envGain_;
+    }
+
+#if RDX_FB_OVERSAMPLE
+    // Same loop as compute(), run twice per sample at half the phase increment so the
+    // feedback path sees 2x the bandwidth, then brought back down by a 7-tap half-band FIR
+    // h = {-1/32, 0, 9/32, 1/2, 9/32, 0, -1/32}. The modulator input is interpolated linearly.
+    inline IRAM_ATTR __attribute__((always_inline, hot)) float computeOversampled(float inputPhaseOffset) {
+        Osc& o = *cur_;
+        if (ramping_) o.inc += o.dInc;
+        const float halfInc = 0.5f * o.inc;
+        const float inMid = 0.5f * (o.osLastInput + inputPhaseOffset);
+        o.osLastInput = inputPhaseOffset;
+
+        const float s0 = oversampleStep(o, inMid, halfInc);
+        const float s1 = oversampleStep(o, inputPhaseOffset, halfInc);
+
+        // half-band: odd taps other than the center are zero, so only every other history slot is read
+        float* h = o.osHist;
+        const float y = 0.5f * h[1] + 0.28125f * (h[0] + h[2]) - 0.03125f * (s1 + h[4]);
+        h[4] = h[2];
+        h[3] = h[1];
+        h[2] = h[0];
+        h[1] = s0;
+        h[0] = s1;
+
+        return y * envGain_;
     }
 
+    inline IRAM_ATTR __attribute__((always_inline)) float oversampleStep(Osc& o, float input, float inc) {
+        if (params_->fbType && o.fbAcc < 0.f) o.fbAcc = -o.fbAcc;
+        o.fbFilter += fbLpCoef2x_ * (o.fbAcc - o.fbFilter);
+        const float lookupPhase = wrap01(o.phase + input + o.fbFilter * fbScale_);
+        o.phase += inc;
+        if (o.phase > 1.0f) o.phase -= 1.0f;
+        o.fbAcc = sin01(lookupPhase);
+        return o.fbAcc;
+    }
+#endif
+
+    inline bool isOversampled() const { return oversample_; }
+
 
     inline void setFrequency(float baseHz) {
 		float freqHz = 0.0f;
 
-		if (params_.freqMode == 0) {  
+		if (params_->freqMode == 0) {  
 			// --- Ratio mode
-			if (params_.freqCoarse > 0)
-				freqHz = baseHz * (params_.freqCoarse + params_.freqFine * 0.01f);
+			if (params_->freqCoarse > 0)
+				freqHz = baseHz * (params_->freqCoarse + params_->freqFine * 0.01f);
 			else
-				freqHz = baseHz * (0.5f + params_.freqFine * 0.005f);
+				freqHz = baseHz * (0.5f + params_->freqFine * 0.005f);
 		} else {  
 			// --- Fixed mode
-			float c = powf(10.0f, fclamp(params_.freqCoarse >> 3, 0.0f, 3.0f));
+			float c = powf(10.0f, fclamp(params_->freqCoarse >> 3, 0.0f, 3.0f));
 			constexpr float n = 9.772f; // scaling base
-			float step = powf(n, params_.freqFine * 0.01010101f );
+			float step = powf(n, params_->freqFine * 0.01010101f );
 			freqHz = c * step;
 		}
 
 		// --- Yamaha detune law (Reface DX)
-		int detuneVal = params_.freqDetune;   // [0..127], 64 = center
+		int detuneVal = params_->freqDetune;   // [0..127], 64 = center
 		int dt = detuneVal - 64;
 		if (dt != 0) {
 			float detuneFactor = powf(1.00033913f, float(dt));
@@ -116,27 +225,53 @@ public:
     inline float getEnvLevel() const { return env_.getLevel(); }
 
 private:
-    RDX_OpParams& params_;
+    RDX_OpParams* params_;
     RDX_Envelope env_;
     RDX_Controls& ctl_ = RDX_State::getState().controls;
-    RDX_Common& common_ = RDX_State::getState().workingPatch.common;
 
     float scaling_ = 1.0f;
     float velogain_ = 1.0f;
+    // note-on context, so live edits can redo scaling and pitch
+    int   note_ = 60;
+    int   vel_ = 100;
+    float baseHz_ = 261.63f;
     bool  enabled_ = true;
-    float fbFilter_ = 0.f;   // LPF state
     float fbLpCoef_ = 0.356f;  // tweak 0.05–0.3 for smoother/rougher harmonics
 
     int idx_ = 0;
+    // per-layer state, layer 0 is the plain voice
+    Osc   osc_[MAX_VOICES_PER_NOTE];
+    Osc*  cur_ = &osc_[0];
+    float layerRatio_[MAX_VOICES_PER_NOTE] = {1.0f};
+    float envGain_   = 0.0f;   // outGain_ * AEG, this sample
+    bool  ramping_   = false;  // pitch moving in this control step
     // runtime state (private members use trailing underscore)
-    float phase_     = 0.0f;   // normalized [0..1)
     float phaseInc_  = 0.0f;   // per-sample increment
-    float fbAcc_     = 0.0f;   // last output for feedback  
     // cached precomputes
     float outGain_   = 1.0f;   // rdxGain(outLevel)
     float fbScale_   = 0.0f;   // feedback scaled coeff
     bool  fbRectify_ = false;   // true for squarish, false for sawish
 
+    // 2x feedback path
+    bool  oversample_ = false;
+    // same cutoff as fbLpCoef_ at twice the rate: 1 - sqrt(1 - 0.356)
+    static constexpr float fbLpCoef2x_ = 0.1975f;
+
+    inline void setOversample() {
+#if RDX_FB_OVERSAMPLE
+        const bool os = params_->enable && params_->feedback > FB_OVERSAMPLE_MIN;
+        if (os != oversample_) clearOversampleState();
+        oversample_ = os;
+#endif
+    }
+
+    inline void clearOversampleState() {
+        for (auto& o : osc_) {
+            for (auto& h : o.osHist) h = 0.f;
+            o.osLastInput = 0.f;
+        }
+    }
+
 
 
 	inline IRAM_ATTR __attribute__((always_inline)) float linearScale(float x) {
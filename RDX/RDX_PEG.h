@@ -45,6 +45,23 @@ public:
         return outVal();
     }
 
+    // n samples at once, for control-rate callers; a stage ending inside the step ends at its border
+    inline IRAM_ATTR __attribute__((always_inline))   float processPEG(uint32_t n) {
+        if (stage_ == Stage::IDLE) return outVal();
+
+        if (stage_ == Stage::SUSTAIN) {
+            if (!gate_) enterStage(Stage::RELEASE);
+            return outVal();
+        }
+
+        current_ += stepIncrement_ * n;
+        if (rising_ ? (current_ >= border_) : (current_ <= border_)) {
+            current_ = border_;
+            advanceStage();
+        }
+        return outVal();
+    }
+
     inline void gate(bool g) {
         bool was = gate_;
         gate_ = g; 
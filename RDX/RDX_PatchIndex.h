@@ -0,0 +1,314 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <algorithm>
+#include "esp_heap_caps.h"
+#include "RDX_Types.h"
+
+// Name index of the open patch folder or dump: one small record per patch with the
+// name and a few tags guessed from the parameters. The browser filters this, so a
+// search over a few thousand patches never touches the files.
+
+static_assert(PATCH_INDEX_MAX <= 65536, "the browser keeps patch numbers in 16 bits");
+
+enum RDX_PatchCategory : uint8_t {
+    PCAT_OTHER = 0,
+    PCAT_BASS,
+    PCAT_KEYS,
+    PCAT_ORGAN,
+    PCAT_BELL,
+    PCAT_BRASS,
+    PCAT_PAD,
+    PCAT_LEAD,
+    PCAT_PLUCK,
+    PCAT_SFX,
+    PCAT_COUNT
+};
+
+static const char* const PCAT_NAMES[PCAT_COUNT] = { "OTHER", "BASS", "KEYS", "ORGAN", "BELL", "BRASS", "PAD", "LEAD", "PLUCK", "SFX" };
+
+enum RDX_PatchTag : uint8_t {
+    PTAG_MONO   = 1 << 0,   // mono or legato
+    PTAG_PORTA  = 1 << 1,   // portamento time set
+    PTAG_LFO    = 1 << 2,   // LFO pitch or amp modulation
+    PTAG_PEG    = 1 << 3,   // pitch EG moves and is routed
+    PTAG_FX     = 1 << 4,   // an effect slot is on
+    PTAG_SLOW   = 1 << 5,   // slow attack
+    PTAG_PERC   = 1 << 6,   // dies away while the key is held
+    PTAG_FIXED  = 1 << 7    // an operator runs at a fixed frequency
+};
+
+static const char* const PTAG_NAMES[8] = { "MONO", "PORTA", "LFO", "PEG", "FX", "SLOW", "PERC", "FIXED" };
+
+// carrier operators of each algorithm, same as RDX_Voice::isActive()
+static constexpr uint8_t RDX_ALGO_CARRIERS[12] = { 1, 1, 1, 1, 1, 3, 3, 5, 7, 7, 7, 15 };
+
+struct __attribute__((packed)) RDX_PatchInfo {
+    char     name[10];   // voice name, printable ASCII
+    uint8_t  algo;       // 0..11
+    uint8_t  carriers;   // 1..4
+    uint8_t  category;   // RDX_PatchCategory
+    uint8_t  tags;       // RDX_PatchTag bits
+};
+
+static inline char rdxFoldChar(char c) { return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c; }
+static inline bool rdxIsLetter(char c) { c = rdxFoldChar(c); return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'); }
+
+// Name words first, two-letter ones only at the start of a word ("EP" but not "STEP").
+// Table order decides between overlaps, HARPSI comes before HARP.
+struct RDX_CategoryWord { const char* word; uint8_t cat; };
+static const RDX_CategoryWord PCAT_WORDS[] = {
+    { "BASS", PCAT_BASS },   { "BS", PCAT_BASS },
+    { "PIANO", PCAT_KEYS },  { "PNO", PCAT_KEYS },   { "EP", PCAT_KEYS },    { "RHODE", PCAT_KEYS },
+    { "WURL", PCAT_KEYS },   { "CLAV", PCAT_KEYS },  { "HARPSI", PCAT_KEYS },{ "KEY", PCAT_KEYS },
+    { "ORG", PCAT_ORGAN },
+    { "BELL", PCAT_BELL },   { "CHIME", PCAT_BELL }, { "MARIM", PCAT_BELL }, { "VIBE", PCAT_BELL },
+    { "GLOCK", PCAT_BELL },  { "CELES", PCAT_BELL }, { "TUBUL", PCAT_BELL },
+    { "BRASS", PCAT_BRASS }, { "BRS", PCAT_BRASS },  { "HORN", PCAT_BRASS }, { "TRUMP", PCAT_BRASS },
+    { "TPT", PCAT_BRASS },   { "SAX", PCAT_BRASS },
+    { "PAD", PCAT_PAD },     { "STR", PCAT_PAD },    { "CHOIR", PCAT_PAD },  { "VOX", PCAT_PAD },
+    { "SWEEP", PCAT_PAD },
+    { "LEAD", PCAT_LEAD },   { "LD", PCAT_LEAD },    { "SOLO", PCAT_LEAD },  { "SYNC", PCAT_LEAD },
+    { "PLUCK", PCAT_PLUCK }, { "GUIT", PCAT_PLUCK }, { "GTR", PCAT_PLUCK },  { "HARP", PCAT_PLUCK },
+    { "KOTO", PCAT_PLUCK },  { "SITAR", PCAT_PLUCK },
+    { "FX", PCAT_SFX },      { "NOISE", PCAT_SFX },  { "WIND", PCAT_SFX },   { "DRUM", PCAT_SFX },
+    { "PERC", PCAT_SFX },
+};
+
+static inline bool rdxNameHas(const char* name, const char* word) {
+    const int n = strlen(word);
+    for (int i = 0; i + n <= 10; ++i) {
+        if (n < 3 && i > 0 && rdxIsLetter(name[i - 1])) continue;
+        int k = 0;
+        while (k < n && rdxFoldChar(name[i + k]) == word[k]) ++k;
+        if (k == n) return true;
+    }
+    return false;
+}
+
+// Fills the record from the patch. The category falls back to the shape of the loudest
+// carrier when the name says nothing: low and fast is a bass, decaying is keys, bell or
+// pluck, a slow attack is a pad, and so on. Rough, but good enough to narrow a list.
+inline void rdxClassifyPatch(const RDX_Patch& p, RDX_PatchInfo& info) {
+    const RDX_Common& c = p.common;
+    for (int i = 0; i < 10; ++i) {
+        const char ch = (char)c.voiceName[i];
+        info.name[i] = (ch < 0x20 || ch > 0x7E) ? ' ' : ch;
+    }
+    info.algo = c.algorithm < 12 ? c.algorithm : 0;
+    const uint8_t cm = RDX_ALGO_CARRIERS[info.algo];
+
+    int main = 0;
+    int mainLevel = -1;
+    bool inharmonic = false;
+    uint8_t tags = 0;
+    info.carriers = 0;
+    for (int op = 0; op < 4; ++op) {
+        const RDX_OpParams& o = p.ops[op];
+        const bool on = o.enable && o.outLevel > 0;
+        if (on && o.freqMode) tags |= PTAG_FIXED;
+        if (on && o.lfoAMD > 0) tags |= PTAG_LFO;
+        if (on && o.lfoPMDEnable && c.lfoPMD > 0) tags |= PTAG_LFO;
+        if (on && o.pegEnable) tags |= PTAG_PEG;   // dropped below if the PEG is flat
+        if (!(cm & (1 << op))) {
+            if (on && (o.freqMode || o.freqFine)) inharmonic = true;
+            continue;
+        }
+        ++info.carriers;
+        if (on && o.outLevel > mainLevel) {
+            mainLevel = o.outLevel;
+            main = op;
+        }
+    }
+
+    int pegDepth = 0;
+    for (int i = 0; i < 4; ++i) pegDepth = max(pegDepth, abs((int)c.pegLevel[i] - 64));
+    if (pegDepth < 4) tags &= ~PTAG_PEG;
+    if (c.monoPoly) tags |= PTAG_MONO;
+    if (c.portaTime) tags |= PTAG_PORTA;
+    if (c.effects[0][0] || c.effects[1][0]) tags |= PTAG_FX;
+
+    const RDX_OpParams& m = p.ops[main];
+    const bool slow = m.egRate[0] < 64;
+    const bool perc = m.egLevel[2] < 16;
+    if (slow) tags |= PTAG_SLOW;
+    if (perc) tags |= PTAG_PERC;
+    info.tags = tags;
+
+    info.category = PCAT_OTHER;
+    for (const auto& w : PCAT_WORDS) {
+        if (rdxNameHas(info.name, w.word)) {
+            info.category = w.cat;
+            return;
+        }
+    }
+    if (m.freqMode || ((tags & PTAG_PEG) && pegDepth > 24))      info.category = PCAT_SFX;
+    else if (!slow && (c.transpose <= 52 || m.freqCoarse == 0))  info.category = PCAT_BASS;
+    else if (perc)     info.category = inharmonic ? PCAT_BELL : (m.egRate[1] >= 90 ? PCAT_PLUCK : PCAT_KEYS);
+    else if (slow)                                               info.category = PCAT_PAD;
+    else if (info.carriers >= 3)                                 info.category = PCAT_ORGAN;
+    else if (c.monoPoly)                                         info.category = PCAT_LEAD;
+}
+
+
+// Filled by PresetManager::open() in the MIDI task, read by the browser in the GUI task.
+// The records live in one PSRAM block that is never moved: a record is written before
+// the count that covers it, and clear() bumps the generation so readers search again.
+// Record i is PresetManager entry i.
+class RDX_PatchIndex {
+public:
+    ~RDX_PatchIndex() { if (info_) heap_caps_free(info_); }
+
+    inline void clear() {
+        count_.store(0, std::memory_order_release);
+        gen_.fetch_add(1, std::memory_order_release);
+    }
+
+    // false when full or out of memory, the patch is still loadable, just not listed
+    inline bool add(const RDX_Patch& p) {
+        RDX_PatchInfo info;
+        rdxClassifyPatch(p, info);
+        return add(info);
+    }
+
+    inline bool add(const RDX_PatchInfo& info) {
+        const uint32_t n = count_.load(std::memory_order_relaxed);
+        if (n >= PATCH_INDEX_MAX || !alloc()) return false;
+        info_[n] = info;
+        count_.store(n + 1, std::memory_order_release);
+        return true;
+    }
+
+    // bulk load from the folder cache: up to PATCH_INDEX_MAX records go to fill(), then publish(n)
+    inline RDX_PatchInfo* fill() { return alloc() ? info_ : nullptr; }
+    inline void publish(uint32_t n) { count_.store(n, std::memory_order_release); }
+
+    inline uint32_t size() const { return count_.load(std::memory_order_acquire); }
+    inline const RDX_PatchInfo* data() const { return info_; }
+    inline uint32_t generation() const { return gen_.load(std::memory_order_acquire); }
+    inline const RDX_PatchInfo& operator[](uint32_t i) const { return info_[i]; }
+
+private:
+    inline bool alloc() {
+        if (!info_) info_ = (RDX_PatchInfo*)heap_caps_malloc(PATCH_INDEX_MAX * sizeof(RDX_PatchInfo), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        return info_ != nullptr;
+    }
+
+    RDX_PatchInfo*          info_ = nullptr;
+    std::atomic<uint32_t>   count_{0};
+    std::atomic<uint32_t>   gen_{0};
+};
+
+
+// What the browser asks for; the query is upper case.
+struct RDX_PatchFilter {
+    char    query[11]   = {0};
+    uint8_t algo        = 0xFF;         // 0..11, 0xFF = any
+    uint8_t carriers    = 0;            // 1..4, 0 = any
+    uint8_t category    = 0xFF;         // RDX_PatchCategory, 0xFF = any
+    uint8_t tags        = 0;            // all of these
+
+    inline bool operator==(const RDX_PatchFilter& f) const {
+        return !strcmp(query, f.query) && algo == f.algo && carriers == f.carriers && category == f.category && tags == f.tags;
+    }
+
+    // every patch f lets through also passes this one, so f's hits are a superset
+    inline bool narrows(const RDX_PatchFilter& f) const {
+        if ((f.algo != 0xFF && f.algo != algo) || (f.carriers && f.carriers != carriers) ||
+            (f.category != 0xFF && f.category != category) || (f.tags & tags) != f.tags) return false;
+        const char* q = query;
+        for (const char* s = f.query; *s; ++s) {
+            while (*q && *q != *s) ++q;
+            if (!*q++) return false;
+        }
+        return true;
+    }
+};
+
+// How well a name matches the query, lower is better:
+// 0 prefix, 1 start of a later word, 2 anywhere, 3 letters in order with gaps, -1 no match.
+static inline int rdxMatchName(const char* name, const char* q, int qn) {
+    if (!qn) return 0;
+    int best = -1;
+    for (int i = 0; i + qn <= 10 && best != 0; ++i) {
+        int k = 0;
+        while (k < qn && rdxFoldChar(name[i + k]) == q[k]) ++k;
+        if (k < qn) continue;
+        const int t = i == 0 ? 0 : (rdxIsLetter(name[i - 1]) ? 2 : 1);
+        if (best < 0 || t < best) best = t;
+    }
+    if (best >= 0) return best;
+    int k = 0;
+    for (int i = 0; i < 10 && k < qn; ++i)
+        if (rdxFoldChar(name[i]) == q[k]) ++k;
+    return k == qn ? 3 : -1;
+}
+
+// Hits of a filter over the index, best matches first and in index order within a tier.
+// Typing one more letter or adding a filter only rescans the previous hits.
+class RDX_PatchSearch {
+public:
+    static constexpr int TIERS = 4;
+
+    ~RDX_PatchSearch() { if (hits_) heap_caps_free(hits_); }
+
+    // true if the hits changed
+    bool update(const RDX_PatchIndex& idx, const RDX_PatchFilter& f) {
+        const uint32_t gen = idx.generation();
+        const uint32_t n = idx.size();
+        if (valid_ && gen == gen_ && n == indexed_ && f == last_) return false;
+        if (!hits_) {
+            // hits, candidates and their tiers in one block
+            hits_ = (uint16_t*)heap_caps_malloc(PATCH_INDEX_MAX * 5, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (!hits_) return false;
+            cand_ = hits_ + PATCH_INDEX_MAX;
+            tier_ = (uint8_t*)(cand_ + PATCH_INDEX_MAX);
+        }
+
+        const bool refine = valid_ && gen == gen_ && n == indexed_ && f.narrows(last_);
+        uint32_t nc = 0;
+        uint32_t count[TIERS] = {0};
+        const int qn = strlen(f.query);
+        const uint32_t from = refine ? count_ : n;
+        for (uint32_t j = 0; j < from; ++j) {
+            const uint16_t i = refine ? hits_[j] : (uint16_t)j;
+            const RDX_PatchInfo& r = idx[i];
+            if ((f.algo != 0xFF && r.algo != f.algo) || (f.carriers && r.carriers != f.carriers) ||
+                (f.category != 0xFF && r.category != f.category) || (r.tags & f.tags) != f.tags) continue;
+            const int t = rdxMatchName(r.name, f.query, qn);
+            if (t < 0) continue;
+            cand_[nc] = i;
+            tier_[nc++] = t;
+            ++count[t];
+        }
+
+        // stable counting sort by tier; a refined list can come in any tier order
+        uint32_t start[TIERS];
+        for (int t = 0, s = 0; t < TIERS; s += count[t++]) start[t] = s;
+        for (uint32_t j = 0; j < nc; ++j) hits_[start[tier_[j]]++] = cand_[j];
+        if (refine) {
+            // keep index order within a tier for the refined list too
+            for (int t = 0, s = 0; t < TIERS; s += count[t++]) std::sort(hits_ + s, hits_ + s + count[t]);
+        }
+
+        count_ = nc;
+        last_ = f;
+        gen_ = gen;
+        indexed_ = n;
+        valid_ = true;
+        return true;
+    }
+
+    inline uint32_t size() const { return valid_ ? count_ : 0; }
+    inline uint16_t operator[](uint32_t i) const { return hits_[i]; }
+
+private:
+    uint16_t*       hits_ = nullptr;
+    uint16_t*       cand_ = nullptr;
+    uint8_t*        tier_ = nullptr;
+    uint32_t        count_ = 0;
+    RDX_PatchFilter last_;
+    uint32_t        gen_ = 0;
+    uint32_t        indexed_ = 0;
+    bool            valid_ = false;
+};
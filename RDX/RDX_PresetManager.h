@@ -4,10 +4,40 @@
 #include <LittleFS.h>
 #include <SD_MMC.h>
 #include <vector>
+#include <atomic>
 #include "RDX_Types.h"
+#include "RDX_PatchIndex.h"
 
 enum class FS_Type { LITTLEFS, SD_MMC };
 
+#ifdef USE_SD
+constexpr FS_Type PATCH_FS = FS_Type::SD_MMC;
+#else
+constexpr FS_Type PATCH_FS = FS_Type::LITTLEFS;
+#endif
+
+// Folder (or dump) cache, "/patches" -> "/patches.rdxindex", next to it rather than inside so
+// it is found without searching a big folder. Layout: header, the patch records, the index
+// records, one uint32_t per entry (name offset or dump offset), then the file names.
+// It is dropped when the folder or dump no longer has the mtime (and size) it was written with,
+// but LittleFS and FatFs mostly leave a folder's mtime alone when its files change, and a file
+// overwritten in place isn't seen at all: after editing the files, rescan() (hold NEXT).
+struct __attribute__((packed)) RDX_IndexHeader {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  isDump;
+    uint8_t  patchSize;     // sizeof(RDX_Patch)
+    uint8_t  infoSize;      // sizeof(RDX_PatchInfo)
+    uint32_t mtime;         // of the folder or dump
+    uint32_t srcSize;       // dump size, 0 for a folder
+    uint32_t count;         // patch records and entries
+    uint32_t indexed;       // index records, up to PATCH_INDEX_MAX
+    uint32_t namesLen;
+};
+
+constexpr uint32_t RDX_INDEX_MAGIC   = 0x49584452;  // "RDXI"
+constexpr uint8_t  RDX_INDEX_VERSION = 1;
+
 class PresetManager {
 public:
     PresetManager() = default;
@@ -16,68 +46,86 @@ public:
         fsType_ = fsType;
         switch (fsType_) {
             case FS_Type::LITTLEFS: return LittleFS.begin(true);
-            case FS_Type::SD_MMC:   return SD_MMC.begin();
+            case FS_Type::SD_MMC:
+                // 4-bit bus; on targets with fixed SDMMC pins this only checks them
+                if (!SD_MMC.setPins(SDMMC_CLK, SDMMC_CMD, SDMMC_D0, SDMMC_D1, SDMMC_D2, SDMMC_D3))
+                    ESP_LOGE("PM", "SD_MMC pins rejected");
+                return SD_MMC.begin("/sdcard", false, false, SDMMC_FREQ_KHZ);
         }
         return false;
     }
 
     // -------------------------------------------------------
     // Open either a directory or a dump file (.syx)
+    // The first open parses every patch and writes the cache, later ones read
+    // the cache. Asking for the folder that is already open (program changes do)
+    // keeps it, rescan = true ignores the cache, e.g. after editing files in place.
     // -------------------------------------------------------
-    bool open(FS_Type fs, const char* path) {
+    bool open(FS_Type fs, const char* path, bool rescan = false) {
+        if (!rescan && !entries_.empty() && fs == currentFS_ && !strcmp(currentPath_, path)) return true;
+        close();
         currentFS_ = fs;
-        currentPath_ = String(path);
-        entries_.clear();
-        currentIndex_ = 0;
+        snprintf(currentPath_, sizeof(currentPath_), "%s", path);
 
-        fs::File f = openFile(currentPath_);
+        fs::File f = fsys().open(currentPath_, "r");
         if(!f) return false;
+        isDump_ = !f.isDirectory();
+        const uint32_t mtime = (uint32_t)f.getLastWrite();
+        const uint32_t srcSize = isDump_ ? f.size() : 0;
+        const uint32_t t0 = millis();
 
-        if(f.isDirectory()) {
-            // Directory mode
-            fs::File entry;
-            while(entry = f.openNextFile()) {
-                if(!entry.isDirectory()) {
-                    String name = String(entry.name());
-                    if(name.endsWith(".syx"))
-                        entries_.push_back(Entry{name, 0, false});
-                }
-                entry.close();
-            }
-            ESP_LOGI("PM","Opened DIR: %s, %d files", path, entries_.size());
-            return !entries_.empty();
-        } 
-        else {
-            // Dump file mode
-            uint32_t len = f.size();
-            if(len < 150) return false;
-
-            uint8_t* buf = new uint8_t[len];
-            f.read(buf, len);
-
-            uint32_t i = 0;
-            while (i + 10 < len) {
-                if (buf[i] == 0xF0 && buf[i + 1] == 0x43) {
-                    // find next F7
-                    uint32_t end = i + 1;
-                    while (end < len && buf[end] != 0xF7) end++;
-                    if (end >= len) break; // malformed
-
-                    uint32_t msgLen = end - i + 1;
-                    RDX_Patch tmp;
-                    if (syxToPatch(buf + i, msgLen, tmp)) {
-                        entries_.push_back(Entry{"", i, true});
-                        i = end + 1; // jump past the message
-                        continue;
-                    }
-                }
-                i++;
-            }
+        if (!rescan && loadCache(mtime, srcSize)) {
+            ESP_LOGI("PM","Opened %s from cache: %d patches, %u ms", path, entries_.size(), (unsigned)(millis() - t0));
+            return true;
+        }
+
+        // streamed into the cache as they are parsed, a failed write just leaves it out
+        char cachePath[sizeof(currentPath_) + 10];
+        cacheName(cachePath);
+        fs::File w = fsys().open(cachePath, "w");
+        RDX_IndexHeader h = {};
+        if (w && w.write((const uint8_t*)&h, sizeof(h)) != sizeof(h)) w.close();
 
-            delete[] buf;
-            ESP_LOGI("PM","Opened DUMP: %s, %d patches", path, entries_.size());
-            return !entries_.empty();
+        if (isDump_) scanDump(f, w);
+        else         scanDir(f, w);
+        f.close();
+
+        if (w) {
+            const uint32_t indexed = index_.size();
+            bool ok = w.write((const uint8_t*)index_.data(), indexed * sizeof(RDX_PatchInfo)) == indexed * sizeof(RDX_PatchInfo)
+                   && w.write((const uint8_t*)entries_.data(), entries_.size() * 4) == entries_.size() * 4
+                   && w.write((const uint8_t*)names_.data(), names_.size()) == names_.size();
+            h = makeHeader(mtime, srcSize);
+            ok = ok && w.seek(0) && w.write((const uint8_t*)&h, sizeof(h)) == sizeof(h);
+            w.close();
+            if (ok) cache_ = fsys().open(cachePath, "r");
+            else    fsys().remove(cachePath);
         }
+
+        ESP_LOGI("PM","Scanned %s: %d patches, %u ms%s", path, entries_.size(), (unsigned)(millis() - t0), cache_ ? ", cached" : "");
+        return !entries_.empty();
+    }
+
+    // The MIDI task and the rescan worker (RDX.ino) share the manager: whoever gets
+    // the lock uses it, the MIDI task never waits and skips the patch change instead.
+    inline bool tryLock() { return !busy_.exchange(true, std::memory_order_acquire); }
+    inline void unlock() { busy_.store(false, std::memory_order_release); }
+
+    // parses the open folder or dump again and rewrites its cache, takes seconds on a big folder
+    bool rescan() {
+        if (!currentPath_[0]) return false;
+        char path[sizeof(currentPath_)];
+        memcpy(path, currentPath_, sizeof(path));
+        return open(currentFS_, path, true);
+    }
+
+    void close() {
+        if (cache_) cache_.close();
+        entries_.clear();
+        names_.clear();
+        index_.clear();
+        aheadCount_ = 0;
+        currentIndex_ = 0;
     }
 
 
@@ -104,73 +152,211 @@ public:
 
     void rewind() { currentIndex_ = 0; }
 
-    std::vector<String> listFiles() const {
-        std::vector<String> list;
-        for (auto &e : entries_)
-            if(!e.isDump) list.push_back(e.name);
-        return list;
+    // file name of a folder entry, nullptr in a dump
+    const char* name(uint32_t i) const {
+        return (isDump_ || i >= entries_.size()) ? nullptr : names_.data() + entries_[i];
     }
 
     uint32_t size() const { return entries_.size(); }
     uint32_t currentIndex() const { return currentIndex_; }
 
-private:
-    struct Entry {
-        String name;     // directory entry name
-        uint32_t offset;   // dump offset
-        bool isDump;     // true = dump patch
-    };
+    // name and tags of every patch, record i is entry i
+    const RDX_PatchIndex& index() const { return index_; }
 
+private:
     FS_Type fsType_;
     FS_Type currentFS_;
-    String currentPath_;
-    std::vector<Entry> entries_;
+    char currentPath_[96] = {0};
+    bool isDump_ = false;
+    std::vector<uint32_t> entries_;   // offset of the name in names_, or of the patch in the dump
+    std::vector<char> names_;         // NUL terminated
+    RDX_PatchIndex index_;
     uint32_t currentIndex_ = 0;
+    std::atomic<bool> busy_{false};
+
+    fs::File cache_;                  // open while the folder is, patches are read from here
+    RDX_Patch ahead_[PATCH_READ_AHEAD];
+    uint32_t aheadFirst_ = 0;
+    uint32_t aheadCount_ = 0;
 
     // -------------------------------------------------------
     // Helpers
     // -------------------------------------------------------
-    fs::File openFile(const String &path) {
-        switch(currentFS_) {
-            case FS_Type::LITTLEFS: return LittleFS.open(path, "r");
-            case FS_Type::SD_MMC:   return SD_MMC.open(path, "r");
+    fs::FS& fsys() {
+        if (currentFS_ == FS_Type::SD_MMC) return SD_MMC;
+        return LittleFS;
+    }
+
+    void cacheName(char* out) {
+        const size_t n = strlen(currentPath_);
+        memcpy(out, currentPath_, n);
+        strcpy(out + n - (n > 1 && currentPath_[n - 1] == '/'), ".rdxindex");
+    }
+
+    RDX_IndexHeader makeHeader(uint32_t mtime, uint32_t srcSize) const {
+        RDX_IndexHeader h = {};
+        h.magic     = RDX_INDEX_MAGIC;
+        h.version   = RDX_INDEX_VERSION;
+        h.isDump    = isDump_;
+        h.patchSize = sizeof(RDX_Patch);
+        h.infoSize  = sizeof(RDX_PatchInfo);
+        h.mtime     = mtime;
+        h.srcSize   = srcSize;
+        h.count     = entries_.size();
+        h.indexed   = index_.size();
+        h.namesLen  = names_.size();
+        return h;
+    }
+
+    bool loadCache(uint32_t mtime, uint32_t srcSize) {
+        char cachePath[sizeof(currentPath_) + 10];
+        cacheName(cachePath);
+        fs::File c = fsys().open(cachePath, "r");
+        if (!c) return false;
+        RDX_IndexHeader h;
+        if (c.read((uint8_t*)&h, sizeof(h)) != sizeof(h) || h.magic != RDX_INDEX_MAGIC || h.version != RDX_INDEX_VERSION ||
+            h.isDump != isDump_ || h.patchSize != sizeof(RDX_Patch) || h.infoSize != sizeof(RDX_PatchInfo) ||
+            h.mtime != mtime || h.srcSize != srcSize || h.indexed > PATCH_INDEX_MAX || h.indexed > h.count) return false;
+
+        RDX_PatchInfo* info = index_.fill();
+        entries_.resize(h.count);
+        names_.resize(h.namesLen);
+        const uint32_t infoBytes = h.indexed * sizeof(RDX_PatchInfo);
+        if (!info || !c.seek(sizeof(h) + h.count * sizeof(RDX_Patch)) ||
+            c.read((uint8_t*)info, infoBytes) != infoBytes ||
+            c.read((uint8_t*)entries_.data(), h.count * 4) != h.count * 4 ||
+            c.read((uint8_t*)names_.data(), h.namesLen) != h.namesLen) {
+            entries_.clear();
+            names_.clear();
+            return false;
         }
-        return fs::File();
+        index_.publish(h.indexed);
+        cache_ = c;
+        return true;
     }
 
-    bool loadCurrent(RDX_Patch &patch) {
-        if(entries_.empty()) return false;
-        const Entry &e = entries_[currentIndex_];
-        if(e.isDump)
-            return loadFromDump(patch, e.offset);
-        else
-            return loadFromFile(patch, e.name);
+    void scanDir(fs::File &dir, fs::File &w) {
+        fs::File entry;
+        RDX_Patch tmp;
+        while(entry = dir.openNextFile()) {
+            const char* n = entry.name();
+            const size_t len = strlen(n);
+            if(!entry.isDirectory() && len > 4 && !strcasecmp(n + len - 4, ".syx") && readPatch(entry, tmp)) {
+                entries_.push_back(names_.size());
+                names_.insert(names_.end(), n, n + len + 1);
+                index_.add(tmp);
+                if (w && w.write((const uint8_t*)&tmp, sizeof(tmp)) != sizeof(tmp)) w.close();
+            }
+            entry.close();
+        }
     }
 
-    bool loadFromFile(RDX_Patch &patch, const String &fname) {
-        fs::File f = openFile(currentPath_ + "/" + fname);
-        if(!f) return false;
+    void scanDump(fs::File &f, fs::File &w) {
         uint32_t len = f.size();
-        if(len < 150) return false;
+        if(len < 150) return;
 
         uint8_t* buf = new uint8_t[len];
         f.read(buf, len);
-        bool ok = syxToPatch(buf, len, patch);
+
+        uint32_t i = 0;
+        while (i + 10 < len) {
+            if (buf[i] == 0xF0 && buf[i + 1] == 0x43) {
+                const uint32_t end = dumpVoiceEnd(buf, len, i);
+                if (!end) break; // malformed
+
+                RDX_Patch tmp = {};
+                if (syxToPatch(buf + i, end - i, tmp)) {
+                    entries_.push_back(i);
+                    index_.add(tmp);
+                    if (w && w.write((const uint8_t*)&tmp, sizeof(tmp)) != sizeof(tmp)) w.close();
+                    i = end; // jump past the voice
+                    continue;
+                }
+            }
+            i++;
+        }
+
         delete[] buf;
-        ESP_LOGI("PM","[DIR] idx %d/%d: %s", currentIndex_, entries_.size(), fname.c_str());
+    }
+
+    bool loadCurrent(RDX_Patch &patch) {
+        if(entries_.empty()) return false;
+        bool ok;
+        if(cache_)
+            ok = loadFromCache(patch, currentIndex_);
+        else if(isDump_)
+            ok = loadFromDump(patch, entries_[currentIndex_]);
+        else
+            ok = loadFromFile(patch, names_.data() + entries_[currentIndex_]);
+        if(isDump_)
+            ESP_LOGI("PM","[DUMP] idx %d/%d, offset=%u", currentIndex_, entries_.size(), (unsigned)entries_[currentIndex_]);
+        else
+            ESP_LOGI("PM","[DIR] idx %d/%d: %s", currentIndex_, entries_.size(), names_.data() + entries_[currentIndex_]);
         return ok;
     }
 
-    bool loadFromDump(RDX_Patch &patch, uint32_t offset) {
-        fs::File f = openFile(currentPath_);
-        if(!f) return false;
-        uint32_t len = f.size();
+    // PATCH_READ_AHEAD records around the one asked for in one read, a quarter of them
+    // behind it so stepping either way stays in the buffer
+    bool loadFromCache(RDX_Patch &patch, uint32_t i) {
+        if(i - aheadFirst_ >= aheadCount_) {
+            const uint32_t n = entries_.size();
+            uint32_t first = i > PATCH_READ_AHEAD / 4 ? i - PATCH_READ_AHEAD / 4 : 0;
+            if(first + PATCH_READ_AHEAD > n) first = n > PATCH_READ_AHEAD ? n - PATCH_READ_AHEAD : 0;
+            const uint32_t count = min<uint32_t>(PATCH_READ_AHEAD, n - first);
+            aheadCount_ = 0;
+            if(!cache_.seek(sizeof(RDX_IndexHeader) + first * sizeof(RDX_Patch)) ||
+               cache_.read((uint8_t*)ahead_, count * sizeof(RDX_Patch)) != count * sizeof(RDX_Patch)) {
+                // gone or cut short under us: back to the files, the next open rebuilds it
+                cache_.close();
+                return isDump_ ? loadFromDump(patch, entries_[i]) : loadFromFile(patch, names_.data() + entries_[i]);
+            }
+            aheadFirst_ = first;
+            aheadCount_ = count;
+        }
+        patch = ahead_[i - aheadFirst_];
+        return true;
+    }
 
-        uint8_t* buf = new uint8_t[len];
-        f.read(buf, len);
-        bool ok = syxToPatch(buf + offset, len - offset, patch);
-        delete[] buf;
-        ESP_LOGI("PM","[DUMP] idx %d/%d, offset=%u", currentIndex_, entries_.size(), (unsigned)offset);
+    // single voice file, a voice dump is 231 bytes
+    bool readPatch(fs::File &f, RDX_Patch &patch) {
+        uint32_t len = f.size();
+        if(len < 150) return false;
+        uint8_t stackBuf[256];
+        uint8_t* buf = len <= sizeof(stackBuf) ? stackBuf : new uint8_t[len];
+        bool ok = f.read(buf, len) == len && syxToPatch(buf, len, patch);
+        if(buf != stackBuf) delete[] buf;
         return ok;
     }
+
+    bool loadFromFile(RDX_Patch &patch, const char* fname) {
+        char path[sizeof(currentPath_) + 64];
+        snprintf(path, sizeof(path), "%s/%s", currentPath_, fname);
+        fs::File f = fsys().open(path, "r");
+        if(!f) return false;
+        return readPatch(f, patch);
+    }
+
+    // just the voice at offset, not the whole dump
+    bool loadFromDump(RDX_Patch &patch, uint32_t offset) {
+        fs::File f = fsys().open(currentPath_, "r");
+        if(!f || !f.seek(offset)) return false;
+        uint8_t buf[256];
+        const uint32_t len = f.read(buf, min<uint32_t>(sizeof(buf), f.size() - offset));
+        const uint32_t end = dumpVoiceEnd(buf, len, 0);
+        return end && syxToPatch(buf, end, patch);
+    }
+
+    // End of the voice whose first message starts at i: through the footer block when it
+    // starts with a header block, else just that message. 0 if cut short.
+    static uint32_t dumpVoiceEnd(const uint8_t* buf, uint32_t len, uint32_t i) {
+        const bool framed = i + 8 < len && buf[i + 8] == 0x0E;
+        while (i < len) {
+            const uint32_t start = i;
+            while (i < len && buf[i] != 0xF7) i++;
+            if (i++ >= len) return 0;
+            if (!framed || (start + 8 < len && buf[start + 8] == 0x0F)) return i;
+            while (i < len && buf[i] != 0xF0) i++;
+        }
+        return 0;
+    }
 };
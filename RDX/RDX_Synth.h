@@ -1,6 +1,7 @@
 // RDX_Synth.h
 #pragma once
 #include <Arduino.h>
+#include <atomic>
 #include "config.h"
 #include "RDX_Voice.h"
 #include "RDX_Types.h"
@@ -20,70 +21,257 @@ public:
         for (auto& v : voices_) {
             v.init();
         }
+        for (int p = 0; p < RDX_PARTS; ++p) {
+            voiceAlloc_[p].setPart(p);
+            markAllDirty(p);
+        }
     }
  
-    inline RDX_Patch& currentPatch() { return state_.workingPatch; }
-    inline const RDX_Patch& currentPatch() const { return state_.workingPatch; }
-
-    inline void applyPatch(const RDX_Patch& patch) {
-        outputGain_ = 0.0f;
+    // part 0, the one the GUI/editor works on
+    inline RDX_Patch& currentPatch() { return state_.workingPatch(); }
+    inline const RDX_Patch& currentPatch() const { return state_.workingPatch(); }
+    inline RDX_Part& part(uint8_t p) { return state_.parts[p < RDX_PARTS ? p : 0]; }
+    inline const RDX_Voice& getVoice(int i) const { return voices_[i]; }
+
+    inline void applyPatch(const RDX_Patch& patch, uint8_t part = 0) {
+        if (part >= RDX_PARTS) return;
+        partGain_[part] = 0.0f;
         for (int i = 0; i < MAX_VOICES; i++) {
-            voices_[i].init();
+            if (voices_[i].part() == part) voices_[i].init();
         }
-        state_.workingPatch = patch; 
+        state_.parts[part].patch = patch; 
         calcOutputGain();
-        state_.storedPatch = patch;
+        if (part == 0) state_.storedPatch = patch;
+        markAllDirty(part);
 #ifdef ENABLE_GUI
         gui.push();
 #endif
     }
 
-    inline void noteOn(uint8_t note, uint8_t vel) {
-        const uint8_t mode = patch_.common.monoPoly;
-        const int idx = voiceAlloc_.findVoice(voices_, VOICES, note, vel, mode);
+    // Sets a part up: channel 0..15 or RDX_PART_OMNI, key range, volume and reserved voices.
+    // Parts on the same channel layer, parts with disjoint key ranges split.
+    inline void setPart(uint8_t p, uint8_t channel, uint8_t keyLow = 0, uint8_t keyHigh = 127, uint8_t volume = 127, uint8_t reserve = 0) {
+        if (p >= RDX_PARTS) return;
+        RDX_Part& pt = state_.parts[p];
+        pt.channel = channel > RDX_PART_OMNI ? RDX_PART_OMNI : channel;
+        pt.keyLow  = keyLow;
+        pt.keyHigh = keyHigh;
+        pt.volume  = volume & 0x7F;
+        pt.reserve = reserve;
+        pt.enabled = true;
+        calcOutputGain();
+    }
+
+    inline void enablePart(uint8_t p, bool on) {
+        if (p >= RDX_PARTS) return;
+        if (!on) voiceAlloc_[p].allSoundOff(voices_, VOICES);
+        state_.parts[p].enabled = on;
+    }
+
+    // -----------------------------------------------------------------
+    // Parameter changes: the byte goes into the part's patch right away,
+    // derived values are redone for its voices at the next block boundary
+    // -----------------------------------------------------------------
+    inline void setCommonParam(uint8_t addr, uint8_t val, uint8_t part = 0) {
+        if (addr >= sizeof(RDX_Common) || part >= RDX_PARTS) return;
+        reinterpret_cast<uint8_t*>(&state_.parts[part].patch.common)[addr] = val;
+        commonDirty_[part].fetch_or(COMMON_PARAM_UPDATE[addr], std::memory_order_release);
+    }
+
+    inline void setOperatorParam(int opNum, uint8_t addr, uint8_t val, uint8_t part = 0) {
+        if (opNum < 0 || opNum > 3) return;
+        if (addr >= sizeof(RDX_OpParams) || part >= RDX_PARTS) return;
+        reinterpret_cast<uint8_t*>(&state_.parts[part].patch.ops[opNum])[addr] = val;
+        opDirty_[part].fetch_or((uint32_t)OP_PARAM_UPDATE[addr] << (8 * opNum), std::memory_order_release);
+    }
+
+    inline void markAllDirty(uint8_t part = 0) {
+        commonDirty_[part].store(RDX_UPD_COMMON_ALL, std::memory_order_release);
+        opDirty_[part].store(0xFFFFFFFF, std::memory_order_release);
+    }
+
+    // audio task, before rendering a block
+    inline void applyUpdates() {
+        for (int p = 0; p < RDX_PARTS; ++p) {
+            if (!(commonDirty_[p].load(std::memory_order_relaxed) | opDirty_[p].load(std::memory_order_relaxed))) continue;
+            const uint8_t common = commonDirty_[p].exchange(0, std::memory_order_acquire);
+            const uint32_t ops = opDirty_[p].exchange(0, std::memory_order_acquire);
+            RDX_Part& pt = state_.parts[p];
+            if (common & RDX_UPD_PORTA) {
+                pt.portaTimeS = AM_DEPTH[pt.patch.common.portaTime] * 2.5f ; // 71ms at 19, 2500ms at 127
+                if (p == 0) ctl_.portaTimeS = pt.portaTimeS;
+            }
+            if (common & RDX_UPD_PB) {
+                setPartPB(p, pt.pitchbend);
+            }
+            if (common & RDX_UPD_ALGO) {
+                calcOutputGain();
+            }
+            for (auto& v : voices_) {
+                if (v.part() == p) v.applyUpdates(common, ops);
+            }
+        }
+    }
 
-        if (mode == RDX_MODE_MONO_LEGATO && voiceAlloc_.legatoPending()) {
-            // legato -> same voice, glide or phase continue
-            voices_[idx].noteOn(note, vel); // if implemented, else noteOn
-        } else {
-            voices_[idx].noteOn(note, vel);
+    // channel 1..16 as the MIDI library reports it
+    inline void noteOn(uint8_t note, uint8_t vel, uint8_t channel = 1) {
+        const uint8_t ch = (channel - 1) & 0x0F;
+        for (int p = 0; p < RDX_PARTS; ++p) {
+            RDX_Part& pt = state_.parts[p];
+            if (!pt.accepts(ch, note)) continue;
+            const uint8_t mode = pt.patch.common.monoPoly;
+            const int idx = voiceAlloc_[p].findVoice(voices_, VOICES, note, vel, mode, rank_);
+            if (idx < 0) continue;
+            RDX_Voice& voice = voices_[idx];
+            if (voiceAlloc_[p].stolen() && voice.isActive()) {
+                // still sounding: the audio task fades it out first, then starts the note
+#if RDX_STEREO
+                voice.queueSteal(p, &pt.patch, note, vel, calcPan(note, idx), ctl_.unisonVoices);
+#else
+                voice.queueSteal(p, &pt.patch, note, vel, 0.0f, ctl_.unisonVoices);
+#endif
+                continue;
+            }
+            if (voice.part() != p) {
+                // taken over from another part: re-point and refresh everything cached
+                voice.bindPart(p, &pt.patch);
+                voice.cacheParams();
+            }
+            voice.setUnison(ctl_.unisonVoices, ctl_.unisonDetune);
+#if RDX_STEREO
+            voice.setPan(calcPan(note, idx));
+#endif
+            voice.noteOn(note, vel);
         }
     }
 
-    inline void noteOff(uint8_t note) {
-        voiceAlloc_.noteOff(voices_, VOICES, note, patch_.common.monoPoly);
+    inline void noteOff(uint8_t note, uint8_t channel = 1) {
+        const uint8_t ch = (channel - 1) & 0x0F;
+        for (int p = 0; p < RDX_PARTS; ++p) {
+            const RDX_Part& pt = state_.parts[p];
+            if (!pt.listens(ch)) continue;
+            voiceAlloc_[p].noteOff(voices_, VOICES, note, pt.patch.common.monoPoly);
+        }
     }
 
 
     inline IRAM_ATTR __attribute__((always_inline)) float process() {
         float mix = 0.f;
-        const float outGain = outputGain_;
         for (int i = 0; i < VOICES; i++) { 
-                mix += voices_[i].step() * outGain;  // step each voice
+                mix += voices_[i].step() * partGain_[voices_[i].part()];  // step each voice
         }
         return mix;
     }
 
+#if RDX_STEREO
+    // voice-major: each voice renders the whole block into the L/R bus with its pan gains
+	inline IRAM_ATTR __attribute__((always_inline, hot))  void renderAudioBlock(float* outL, float* outR, uint32_t len = DMA_BUFFER_LEN) {
+        applyUpdates();
+        memset(outL, 0, len * sizeof(float));
+        memset(outR, 0, len * sizeof(float));
+        renderSteals(outL, outR, len);
+        for (int v = 0; v < VOICES; v++) {
+            RDX_Voice& voice = voices_[v];
+            const float outGain = partGain_[voice.part()];
+            voice.updateLfo(len);
+            if (voice.layers() > 1) {
+                // unison: one modulation/envelope pass per sample, layers panned by the voice
+                float sL, sR;
+                for (uint32_t i = 0; i < len; ++i) {
+                    voice.stepStereo(sL, sR);
+                    outL[i] += sL * outGain;
+                    outR[i] += sR * outGain;
+                }
+                continue;
+            }
+            const float gL = voice.panL() * outGain;
+            const float gR = voice.panR() * outGain;
+            for (uint32_t i = 0; i < len; ++i) {
+                const float s = voice.step();
+                outL[i] += s * gL;
+                outR[i] += s * gR;
+            }
+        }
+        rank_.update(voices_, VOICES, ctl_.stealMode);
+	}
+#else
 	inline IRAM_ATTR __attribute__((always_inline, hot))  void renderAudioBlock(float* outL, float* outR, uint32_t len = DMA_BUFFER_LEN) {
 		float sample = 0.f;
+        applyUpdates();
+        memset(outL, 0, len * sizeof(float));
+        memset(outR, 0, len * sizeof(float));
+        renderSteals(outL, outR, len);
         for (int i = 0; i < VOICES; i++) {
-            voices_[i].updateLfo();
+            voices_[i].updateLfo(len);
         }
-		for (int i = 0; i < len; ++i) {
+		for (uint32_t i = 0; i < len; ++i) {
             sample = process();  // sum of active voices
 
-            outL[i] = sample;
-            outR[i] = sample;
+            outL[i] += sample;
+            outR[i] += sample;
 		}
+        rank_.update(voices_, VOICES, ctl_.stealMode);
 	}
+#endif
 
+    // Stolen voices: the old sound fades out over RDX_STEAL_FADE samples, then the new note starts.
+    // Its block is rendered on top, so the two overlap for the fade instead of clicking.
+    inline void renderSteals(float* outL, float* outR, uint32_t len) {
+        const uint32_t n = len < RDX_STEAL_FADE ? len : RDX_STEAL_FADE;
+        const float dg = 1.0f / n;
+        for (int v = 0; v < VOICES; v++) {
+            RDX_Voice& voice = voices_[v];
+            if (!voice.stealPending()) continue;
+            const float outGain = partGain_[voice.part()];
+#if RDX_STEREO
+            if (voice.layers() > 1) {
+                // unison fades as it sounds, layers spread the same as in the voice loop
+                float g = 1.0f;
+                float sL, sR;
+                for (uint32_t i = 0; i < n; ++i) {
+                    g -= dg;
+                    voice.stepStereo(sL, sR);
+                    outL[i] += sL * g * outGain;
+                    outR[i] += sR * g * outGain;
+                }
+                voice.startSteal();
+                continue;
+            }
+            const float gL = voice.panL() * outGain;
+            const float gR = voice.panR() * outGain;
+#else
+            const float gL = outGain;
+            const float gR = outGain;
+#endif
+            float g = 1.0f;
+            for (uint32_t i = 0; i < n; ++i) {
+                g -= dg;
+                const float s = voice.step() * g;
+                outL[i] += s * gL;
+                outR[i] += s * gR;
+            }
+            voice.startSteal();
+        }
+    }
 
-    inline void updateCache() {
-        voices_[voiceUpdateIdx_].cacheParams();
-        voiceUpdateIdx_ ++;
-        if (voiceUpdateIdx_ >= VOICES) voiceUpdateIdx_ = 0;
+    // pan position for a voice; a unison stack spreads its layers around it
+    inline float calcPan(uint8_t note, int voiceIdx) const {
+        float pan = 0.f;
+        switch (ctl_.panMode) {
+            case RDX_PAN_NOTE:
+                pan = ((float)note - 60.f) * (1.f / 36.f);  // C1..C8 sweep the field
+                break;
+            case RDX_PAN_VOICE:
+                pan = (MAX_VOICES > 1) ? (2.f * voiceIdx / (float)(MAX_VOICES - 1) - 1.f) : 0.f;
+                if (voiceIdx & 1) pan = -pan; // neighbours go to opposite sides
+                break;
+            default:
+                break;
+        }
+        return fclamp(pan, -1.f, 1.f) * ctl_.panSpread;
     }
 
+
 	// Hardcoded DigiChord patch
 	inline RDX_Patch DigiChordPatch() {
 		RDX_Patch p{};
@@ -187,6 +375,13 @@ public:
 	}
 
     void processCC(int channel, uint8_t cc, uint8_t val) {
+        const uint8_t ch = (channel - 1) & 0x0F;
+        // patch-level CCs go to every part listening on the channel
+        auto forParts = [&](auto&& fn) {
+            for (uint8_t p = 0; p < RDX_PARTS; ++p) {
+                if (state_.parts[p].listens(ch)) fn(p);
+            }
+        };
         switch (cc) {
             case 0:  // Bank Select MSB
                 ctl_.wantBankMSB = val & 0x7F;
@@ -199,12 +394,14 @@ public:
                 ctl_.modWheelFactor = val * MIDI_NORM;
                 break;
             case 5:
-                patch_.common.portaTime = val;
-                ctl_.portaTimeS = 0.06f + (val - 64) * MIDI_NORM  * 0.059f * 2.0f;
+                forParts([&](uint8_t p) { setCommonParam(14, val, p); });
                 break;
             case 7:
-                ctl_.mainVolume = val & 0x7F;
-                ctl_.mainVolumeFactor = val * MIDI_NORM;
+                if (state_.parts[0].listens(ch)) {
+                    ctl_.mainVolume = val & 0x7F;
+                    ctl_.mainVolumeFactor = val * MIDI_NORM;
+                }
+                forParts([&](uint8_t p) { if (p) state_.parts[p].volume = val & 0x7F; });
                 calcOutputGain();
                 break;
             case 64: 
@@ -226,80 +423,90 @@ public:
                 break;
             // ========= PATCH COMMON ===============
             case 80:
-                patch_.common.algorithm = val * 12 / 128; break;
-                ESP_LOGI("CC","set aalgo to %d", patch_.common.algorithm);
+                forParts([&](uint8_t p) { setCommonParam(16, val * 12 / 128, p); }); break;
             // ========= OP 1 =======================    
             case 85:
-                patch_.ops[0].outLevel = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(0, 18, val, p); }); break;
             case 86:
-                patch_.ops[0].feedback = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(0, 19, val, p); }); break;
             case 87:
-                patch_.ops[0].fbType = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(0, 20, val, p); }); break;
             case 88:
-                patch_.ops[0].freqMode = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(0, 21, val, p); }); break;
             case 89:
-                patch_.ops[0].freqCoarse = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(0, 22, val, p); }); break;
             case 90:
-                patch_.ops[0].freqFine = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(0, 23, val, p); }); break;
 
             // ========= OP 2 =======================    
             case 102:
-                patch_.ops[1].outLevel = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(1, 18, val, p); }); break;
             case 103:
-                patch_.ops[1].feedback = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(1, 19, val, p); }); break;
             case 104:
-                patch_.ops[1].fbType = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(1, 20, val, p); }); break;
             case 105:
-                patch_.ops[1].freqMode = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(1, 21, val, p); }); break;
             case 106:
-                patch_.ops[1].freqCoarse = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(1, 22, val, p); }); break;
             case 107:
-                patch_.ops[1].freqFine = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(1, 23, val, p); }); break;
                 
             // ========= OP 1 =======================    
             case 108:
-                patch_.ops[2].outLevel = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(2, 18, val, p); }); break;
             case 109:
-                patch_.ops[2].feedback = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(2, 19, val, p); }); break;
             case 110:
-                patch_.ops[2].fbType = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(2, 20, val, p); }); break;
             case 111:
-                patch_.ops[2].freqMode = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(2, 21, val, p); }); break;
             case 112:
-                patch_.ops[2].freqCoarse = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(2, 22, val, p); }); break;
             case 113:
-                patch_.ops[2].freqFine = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(2, 23, val, p); }); break;
                 
             // ========= OP 1 =======================    
             case 114:
-                patch_.ops[3].outLevel = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(3, 18, val, p); }); break;
             case 115:
-                patch_.ops[3].feedback = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(3, 19, val, p); }); break;
             case 116:
-                patch_.ops[3].fbType = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(3, 20, val, p); }); break;
             case 117:
-                patch_.ops[3].freqMode = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(3, 21, val, p); }); break;
             case 118:
-                patch_.ops[3].freqCoarse = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(3, 22, val, p); }); break;
             case 119:
-                patch_.ops[3].freqFine = val; break;
+                forParts([&](uint8_t p) { setOperatorParam(3, 23, val, p); }); break;
             case 120:
-                voiceAlloc_.allSoundOff(voices_, VOICES);
+                forParts([&](uint8_t p) { voiceAlloc_[p].allSoundOff(voices_, VOICES); });
             case 123:
-                voiceAlloc_.allNotesOff(voices_, VOICES);
+                forParts([&](uint8_t p) { voiceAlloc_[p].allNotesOff(voices_, VOICES); });
         }
     }
 
 
+    // channel 1..16, bends the parts listening there, each through its own PB range
     void updatePB(int channel, int val) {
+        const uint8_t ch = (channel - 1) & 0x0F;
         ctl_.pitchbend = val;
-        float pbNorm = val / 8192.0f;
-        ctl_.pitchbendSemitones = pbNorm * ((float)(patch_.common.pbRange - 64));
+        for (uint8_t p = 0; p < RDX_PARTS; ++p) {
+            if (state_.parts[p].listens(ch)) setPartPB(p, val);
+        }
+    }
+
+    inline void setPartPB(uint8_t p, int val) {
+        RDX_Part& pt = state_.parts[p];
+        pt.pitchbend = val;
+        pt.pitchbendSemitones = val / 8192.0f * ((float)(pt.patch.common.pbRange - 64));
+        if (p == 0) ctl_.pitchbendSemitones = pt.pitchbendSemitones;
     }
 
 
+    // channel 1..16
     void programChange(uint8_t ch, uint8_t program) {
-        if (ch >= 16) return;
+        if (ch < 1 || ch > 16) return;
 
         ctl_.wantProgram = program & 0x7F;
 
@@ -307,18 +514,27 @@ public:
     }
 
     inline void applyBankProgram(uint8_t ch) {
-        voiceAlloc_.clearStack();
+        const uint8_t c = (ch - 1) & 0x0F;
+        for (uint8_t p = 0; p < RDX_PARTS; ++p) {
+            if (state_.parts[p].listens(c)) applyBankProgram(ch, p);
+        }
+    }
+
+    inline void applyBankProgram(uint8_t ch, uint8_t part) {
+        voiceAlloc_[part].clearStack();
         const uint8_t program = ctl_.wantProgram;
         const uint16_t bank   = ctl_.getWantBank();
         RDX_Patch patch;
         if (bank == 0 ) {
-            if (pm.open(FS_Type::LITTLEFS, "/patches") ) {
+            if (!pm.tryLock()) return;  // the folder is being rescanned
+            if (pm.open(PATCH_FS, PATCH_DIR) ) {
                 pm.openByIndex(program+1, patch); 
             } else {
                 patch = DigiChordPatch(); // hardcoded patch
             }
+            pm.unlock();
         }
-        applyPatch(patch);
+        applyPatch(patch, part);
     }
 
     void calcOutputGain() {
@@ -329,36 +545,41 @@ public:
         }
 
         polyMixCoeff_ = 0.8f / sqrtf((float)MAX_VOICES);
-        int algo = state_.workingPatch.common.algorithm;
-        
-        switch (algo) {
-            case 5:
-            case 6:
-            case 7:
-                algoMixCoeff_ = ONE_DIV_SQRT2  ; break;
-            case 8:
-            case 9:
-            case 10:
-                algoMixCoeff_ = ONE_DIV_SQRT3  ; break;
-            case 11:
-                algoMixCoeff_ = 0.5f  ; break;
-            default:
-                algoMixCoeff_ = 1.0f  ; break;
+        for (int p = 0; p < RDX_PARTS; ++p) {
+            const RDX_Part& pt = state_.parts[p];
+            float algoMix;
+            switch (pt.patch.common.algorithm) {
+                case 5:
+                case 6:
+                case 7:
+                    algoMix = ONE_DIV_SQRT2  ; break;
+                case 8:
+                case 9:
+                case 10:
+                    algoMix = ONE_DIV_SQRT3  ; break;
+                case 11:
+                    algoMix = 0.5f  ; break;
+                default:
+                    algoMix = 1.0f  ; break;
+            }
+            if (p == 0) algoMixCoeff_ = algoMix;
+            partGain_[p] = algoMix * ctl_.mainVolumeFactor * polyMixCoeff_ * (pt.volume * MIDI_NORM);
         }
-        outputGain_ = algoMixCoeff_ * ctl_.mainVolumeFactor * polyMixCoeff_ ;
     }
     RDX_Voice& getVoice(int idx)  {return voices_[idx];}
 
 private:
     RDX_Voice           voices_[MAX_VOICES];
-    RDX_VoiceAllocator  voiceAlloc_;
+    RDX_VoiceAllocator  voiceAlloc_[RDX_PARTS];
+    RDX_VoiceRank       rank_;
     SynthState&         state_  = RDX_State::getState(); 
     RDX_Controls&       ctl_    = RDX_State::getState().controls;
-    RDX_Patch&          patch_  = RDX_State::getState().workingPatch;
+    RDX_Patch&          patch_  = RDX_State::getState().workingPatch();
  
     float algoMixCoeff_ = 1.0f;
     float polyMixCoeff_ = 1.0f;
-    float outputGain_ = 1.0f;
+    float partGain_[RDX_PARTS] = {};
 
-    int voiceUpdateIdx_ = 0;
+    std::atomic<uint8_t>  commonDirty_[RDX_PARTS] = {};   // RDX_CommonUpdate bits, per part
+    std::atomic<uint32_t> opDirty_[RDX_PARTS] = {};       // RDX_OpUpdate bits, a byte per operator
 };
@@ -0,0 +1,188 @@
+// RDX_Sysex.h
+#pragma once
+#include <Arduino.h>
+#include <cstring>
+#include "RDX_Types.h"
+
+// ---------------------------------------------------------
+// Streaming receiver for Reface DX bulk dumps
+//
+//  F0 43 0n 7F 1C <countH> <countL> 05 <addrH> <addrM> <addrL> <data...> <sum> F7
+//
+// Bytes go straight into a staged patch, no message buffer and no heap.
+// A voice is header (0E), common (30), 4 x operator (31), footer (0F),
+// each a separate SysEx message; the patch is handed out only when the
+// footer arrives and every block in between passed its checksum.
+// ---------------------------------------------------------
+class RDX_SysexBulk {
+public:
+    enum Result : uint8_t {
+        SYX_NONE = 0,   // nothing complete yet (or a header/part of a dump)
+        SYX_BLOCK,      // a valid block was staged
+        SYX_PATCH,      // footer: patch() holds a complete voice
+        SYX_SYSTEM,     // system() holds a complete system block
+        SYX_ERROR       // malformed message or checksum mismatch
+    };
+
+    inline void reset() {
+        state_ = S_IDLE;
+        blocks_ = 0;
+        inBulk_ = false;
+    }
+
+    // Feeds a whole message or any part of it, the state carries over between calls.
+    // Returns the most significant result seen in this chunk.
+    inline Result feed(const uint8_t* data, uint32_t len) {
+        Result res = SYX_NONE;
+        for (uint32_t i = 0; i < len; ++i) {
+            const Result r = feedByte(data[i]);
+            if (r > res) res = r;
+        }
+        return res;
+    }
+
+    inline Result feedByte(uint8_t b) {
+        if (b == 0xF0) { state_ = S_MANUF; return SYX_NONE; }
+        if ((b & 0x80) && b != 0xF7) return SYX_NONE;    // realtime bytes may be interleaved
+
+        switch (state_) {
+            case S_IDLE:
+            case S_SKIP:
+                return SYX_NONE;
+            case S_MANUF:   return expect(b == 0x43, S_DEVICE);
+            case S_DEVICE:  return expect((b & 0xF0) == 0x00, S_GROUP_H);   // bulk dump only
+            case S_GROUP_H: return expect(b == 0x7F, S_GROUP_L);
+            case S_GROUP_L: return expect(b == 0x1C, S_COUNT_H);
+            case S_COUNT_H:
+                count_ = (uint32_t)b << 7;
+                state_ = S_COUNT_L;
+                return SYX_NONE;
+            case S_COUNT_L:
+                count_ |= b;
+                state_ = S_MODEL;
+                return SYX_NONE;
+            case S_MODEL:
+                sum_ = b;
+                return expect(b == 0x05, S_ADDR_H);
+            case S_ADDR_H:
+                sum_ += b;
+                addr_[0] = b;
+                state_ = S_ADDR_M;
+                return SYX_NONE;
+            case S_ADDR_M:
+                sum_ += b;
+                addr_[1] = b;
+                state_ = S_ADDR_L;
+                return SYX_NONE;
+            case S_ADDR_L:
+                sum_ += b;
+                addr_[2] = b;
+                return beginBlock();
+            case S_DATA:
+                if (b == 0xF7) return fail();
+                dst_[pos_++] = b;
+                if (pos_ >= size_) state_ = S_CHECK;
+                return SYX_NONE;
+            case S_CHECK:
+                if (b == 0xF7) return fail();
+                check_ = b;
+                state_ = S_END;
+                return SYX_NONE;
+            case S_END:
+                state_ = S_IDLE;
+                if (b != 0xF7) return fail();
+                return endBlock();
+        }
+        return SYX_NONE;
+    }
+
+    inline const RDX_Patch& patch() const { return staged_; }
+    inline const RDX_System& system() const { return system_; }
+
+private:
+    enum State : uint8_t {
+        S_IDLE, S_SKIP, S_MANUF, S_DEVICE, S_GROUP_H, S_GROUP_L, S_COUNT_H, S_COUNT_L,
+        S_MODEL, S_ADDR_H, S_ADDR_M, S_ADDR_L, S_DATA, S_CHECK, S_END
+    };
+    enum Block : uint8_t { B_COMMON = 0, B_OP0 = 1, B_ALL = 0x1F };    // B_OP0 << n for operator n
+
+    RDX_Patch  staged_{};
+    RDX_System system_{};
+    uint8_t*   dst_ = nullptr;
+    uint32_t   size_ = 0;
+    uint32_t   pos_ = 0;
+    uint32_t   count_ = 0;
+    uint32_t   sum_ = 0;            // model + address bytes, the data is summed at the end
+    uint8_t    addr_[3] = {0};
+    uint8_t    check_ = 0;
+    uint8_t    blockBit_ = 0;
+    uint8_t    blocks_ = 0;         // staged blocks of the current dump
+    bool       inBulk_ = false;
+    State      state_ = S_IDLE;
+
+    inline Result expect(bool ok, State next) {
+        state_ = ok ? next : S_SKIP;
+        return SYX_NONE;
+    }
+
+    inline Result fail() {
+        state_ = S_IDLE;
+        blocks_ &= ~blockBit_;
+        return SYX_ERROR;
+    }
+
+    inline Result beginBlock() {
+        const uint32_t dataLen = (count_ > 4) ? count_ - 4 : 0;
+        dst_ = nullptr;
+        size_ = 0;
+        pos_ = 0;
+        blockBit_ = 0;
+        switch (addr_[0]) {
+            case 0x00:  // system
+                dst_ = reinterpret_cast<uint8_t*>(&system_);
+                size_ = sizeof(RDX_System);
+                break;
+            case 0x0E:  // bulk header, starts a fresh voice
+            case 0x0F:  // bulk footer
+                break;
+            case 0x30:  // common
+                dst_ = reinterpret_cast<uint8_t*>(&staged_.common);
+                size_ = sizeof(RDX_Common);
+                blockBit_ = 1 << B_COMMON;
+                break;
+            case 0x31:  // operator
+                if (addr_[1] > 3) return fail();
+                dst_ = reinterpret_cast<uint8_t*>(&staged_.ops[addr_[1]]);
+                size_ = sizeof(RDX_OpParams);
+                blockBit_ = 1 << (B_OP0 + addr_[1]);
+                break;
+            default:
+                state_ = S_SKIP;
+                return SYX_NONE;
+        }
+        if (dataLen != size_) return fail();
+        state_ = size_ ? S_DATA : S_CHECK;
+        return SYX_NONE;
+    }
+
+    inline Result endBlock() {
+        if (rdxSyxChecksum(dst_, size_, sum_) != check_) return fail();
+        switch (addr_[0]) {
+            case 0x00:
+                return SYX_SYSTEM;
+            case 0x0E:
+                inBulk_ = true;
+                blocks_ = 0;
+                return SYX_NONE;
+            case 0x0F: {
+                const bool complete = inBulk_ && blocks_ == B_ALL;
+                inBulk_ = false;
+                blocks_ = 0;
+                return complete ? SYX_PATCH : SYX_ERROR;
+            }
+            default:
+                blocks_ |= blockBit_;
+                return SYX_BLOCK;
+        }
+    }
+};
@@ -1,6 +1,7 @@
 // RDX_Types.h
 #pragma once
 #include <cstdint>
+#include "config.h"
 
 // ===============================
 // Reface DX data types & structs
@@ -37,6 +38,26 @@ enum RDX_Mode : uint8_t {
     RDX_MODE_MONO_LEGATO = 2
 };
 
+// stereo placement of voices
+enum RDX_PanMode : uint8_t {
+    RDX_PAN_CENTER = 0,     // all voices in the middle
+    RDX_PAN_NOTE   = 1,     // low notes left, high notes right
+    RDX_PAN_VOICE  = 2      // voices spread by their index
+};
+
+// which held note sounds in mono modes, and which voice goes first when a poly part steals
+enum RDX_NotePriority : uint8_t {
+    RDX_PRIO_LAST = 0,      // newest note wins, poly steals by RDX_StealMode
+    RDX_PRIO_LOW  = 1,      // lowest note wins, poly steals the part's highest note
+    RDX_PRIO_HIGH = 2       // highest note wins, poly steals the part's lowest note
+};
+
+// victim order when the pool is full
+enum RDX_StealMode : uint8_t {
+    RDX_STEAL_QUIETEST = 0, // released first, then lowest carrier level x velocity
+    RDX_STEAL_OLDEST   = 1  // released first, then the earliest note-on
+};
+
 
 // ---------------------------------------------------------
 // Yamaha Reface DX checksum helper
@@ -48,6 +69,12 @@ inline uint8_t rdxSyxChecksum(const uint8_t* data, uint32_t len) {
     return (128 - (sum & 0x7F)) & 0x7F;
 }
 
+// Continues a running sum, for blocks whose address bytes were consumed separately
+inline uint8_t rdxSyxChecksum(const uint8_t* data, uint32_t len, uint32_t sum) {
+    for (uint32_t i = 0; i < len; ++i) sum += data[i];
+    return (128 - (sum & 0x7F)) & 0x7F;
+}
+
 // Convenience overload for direct brace-init usage
 inline uint8_t rdxSyxChecksum(std::initializer_list<uint8_t> list) {
     uint32_t sum = 0;
@@ -76,6 +103,22 @@ struct RDX_Controls {
     
     float portaTimeS = 0.06f; // 60ms
 
+    // stereo
+    uint8_t panMode = RDX_PAN_NOTE;
+    uint8_t stealMode = RDX_STEAL_QUIETEST;
+    float panSpread = 0.5f;    // 0 = mono .. 1 = full width
+    float unisonSpread = 0.7f; // width of a unison stack around the voice pan
+    uint8_t unisonVoices = 1;  // layers per note, 1..MAX_VOICES_PER_NOTE
+    float unisonDetune = 12.0f; // cents between the outer layers and the note
+
+    // external audio input (AUDIO_INPUT)
+    float inputLevel = 1.0f;       // input gain into the bus before FX, 0 = sidechain only
+    bool  inputSidechain = false;  // touch-wah envelope follows the input instead of the bus
+
+    // tempo sync, RDX_TempoDiv
+    uint8_t lfoSync   = 255;       // LFO cycle length, TEMPO_FREE = patch LFO speed
+    uint8_t delaySync = 255;       // delay time, TEMPO_FREE = patch delay time
+
 	// bank / program
     uint32_t  bankMSB = 0;     // CC#0
     uint32_t  bankLSB = 0;     // CC#32
@@ -209,6 +252,61 @@ struct __attribute__((packed)) RDX_OpParams {
     uint8_t reserved[3];   // 25-27: reserved
 };
 
+// ---------------------------------------------------------
+// Parameter change dispatch: what each patch byte invalidates.
+// Bytes marked NONE are read where they're used (note-on, FX host, pitch bend).
+// ---------------------------------------------------------
+enum RDX_CommonUpdate : uint8_t {
+    RDX_UPD_NONE    = 0,
+    RDX_UPD_PORTA   = 1 << 0,   // portamento time
+    RDX_UPD_PB      = 1 << 1,   // pitch bend range
+    RDX_UPD_ALGO    = 1 << 2,   // algorithm, carrier mix
+    RDX_UPD_LFO     = 1 << 3,   // LFO wave/speed/delay/PMD
+    RDX_UPD_PEG     = 1 << 4,   // pitch EG rates/levels
+    RDX_UPD_COMMON_ALL = 0x1F
+};
+
+enum RDX_OpUpdate : uint8_t {
+    RDX_UPD_OP_LEVEL = 1 << 0,  // out level
+    RDX_UPD_OP_SCALE = 1 << 1,  // level scaling, velocity sensitivity
+    RDX_UPD_OP_EG    = 1 << 2,  // AEG rates/levels
+    RDX_UPD_OP_FB    = 1 << 3,  // on/off, feedback amount/type
+    RDX_UPD_OP_FREQ  = 1 << 4,  // frequency mode/coarse/fine/detune
+    RDX_UPD_OP_MOD   = 1 << 5,  // LFO AMD, PMD on/off, PEG on/off
+    RDX_UPD_OP_ALL   = 0x3F
+};
+
+constexpr uint8_t COMMON_PARAM_UPDATE[38] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0,                               // 0..9   voice name
+    0, 0,                                                       // 10..11 reserved
+    RDX_UPD_NONE,                                               // 12     transpose (note-on)
+    RDX_UPD_NONE,                                               // 13     mono/poly (note-on, FX host)
+    RDX_UPD_PORTA,                                              // 14     porta time
+    RDX_UPD_PB,                                                 // 15     PB range
+    RDX_UPD_ALGO,                                               // 16     algorithm
+    RDX_UPD_LFO, RDX_UPD_LFO, RDX_UPD_LFO, RDX_UPD_LFO,         // 17..20 LFO wave, speed, delay, PMD
+    RDX_UPD_PEG, RDX_UPD_PEG, RDX_UPD_PEG, RDX_UPD_PEG,         // 21..24 PEG rates
+    RDX_UPD_PEG, RDX_UPD_PEG, RDX_UPD_PEG, RDX_UPD_PEG,         // 25..28 PEG levels
+    0, 0, 0, 0, 0, 0,                                           // 29..34 effects (FX host follows them)
+    0, 0, 0                                                     // 35..37 reserved
+};
+
+constexpr uint8_t OP_PARAM_UPDATE[28] = {
+    RDX_UPD_OP_FB,                                              // 0      on/off
+    RDX_UPD_OP_EG, RDX_UPD_OP_EG, RDX_UPD_OP_EG, RDX_UPD_OP_EG, // 1..4   EG rates
+    RDX_UPD_OP_EG, RDX_UPD_OP_EG, RDX_UPD_OP_EG, RDX_UPD_OP_EG, // 5..8   EG levels
+    RDX_UPD_OP_EG,                                              // 9      rate scaling
+    RDX_UPD_OP_SCALE, RDX_UPD_OP_SCALE,                         // 10..11 scaling depths
+    RDX_UPD_OP_SCALE, RDX_UPD_OP_SCALE,                         // 12..13 scaling curves
+    RDX_UPD_OP_MOD, RDX_UPD_OP_MOD, RDX_UPD_OP_MOD,             // 14..16 LFO AMD, PMD on, PEG on
+    RDX_UPD_OP_SCALE,                                           // 17     velocity sens
+    RDX_UPD_OP_LEVEL,                                           // 18     out level
+    RDX_UPD_OP_FB, RDX_UPD_OP_FB,                               // 19..20 feedback, FB type
+    RDX_UPD_OP_FREQ, RDX_UPD_OP_FREQ,                           // 21..22 freq mode, coarse
+    RDX_UPD_OP_FREQ, RDX_UPD_OP_FREQ,                           // 23..24 fine, detune
+    0, 0, 0                                                     // 25..27 reserved
+};
+
 // ---------------------------------------------------------
 // Full patch (38 + 4*28 = 150 bytes)
 // ---------------------------------------------------------
@@ -217,6 +315,9 @@ struct __attribute__((packed)) RDX_Patch {
     RDX_OpParams ops[4];     // 112 bytes
 };
 
+static_assert(sizeof(RDX_Common) == sizeof(COMMON_PARAM_UPDATE), "COMMON_PARAM_UPDATE out of sync with RDX_Common");
+static_assert(sizeof(RDX_OpParams) == sizeof(OP_PARAM_UPDATE), "OP_PARAM_UPDATE out of sync with RDX_OpParams");
+
 // ---------------------------------
 // Bank Parameters (future)
 // ---------------------------------
@@ -225,12 +326,99 @@ struct RDX_Bank {
 };
 
 
+// ---------------------------------
+// Audio engine block setup (runtime)
+// ---------------------------------
+struct RDX_AudioConfig {
+    uint32_t blockLen       = DMA_BUFFER_LEN;   // samples per render block == DMA frame count
+    uint32_t dmaBufNum      = DMA_BUFFER_NUM;   // DMA descriptors in flight
+    float    divBlockLen    = 1.0f / DMA_BUFFER_LEN;
+
+    // requested setup, the audio task picks it up at the next block boundary
+    volatile bool changePending = false;
+    uint32_t wantBlockLen   = DMA_BUFFER_LEN;
+    uint32_t wantDmaBufNum  = DMA_BUFFER_NUM;
+
+    // render block + queued DMA buffers, output only
+    inline float outputLatencyMs() const { return 1000.0f * blockLen * (dmaBufNum + 1) / (float)SAMPLE_RATE; }
+    // input DMA + render + output DMA
+    inline float roundTripLatencyMs() const { return 1000.0f * blockLen * (2 * dmaBufNum + 1) / (float)SAMPLE_RATE; }
+};
+
+// ---------------------------------
+// Tempo
+// ---------------------------------
+// note lengths for tempo sync, same order as DelayTimeDiv
+enum RDX_TempoDiv : uint8_t {
+    TEMPO_1_1 = 0,
+    TEMPO_1_2,
+    TEMPO_1_4,
+    TEMPO_1_8,
+    TEMPO_1_16,
+    TEMPO_1_8T,
+    TEMPO_1_8D,
+    TEMPO_FREE = 255
+};
+
+constexpr float TEMPO_DIV_BEATS[] = { 4.0f, 2.0f, 1.0f, 0.5f, 0.25f, 1.0f / 3.0f, 0.75f };
+
+// Written by the audio task once per block from the MIDI clock, which runs on the sample counter.
+struct RDX_Transport {
+    volatile uint32_t samplePos    = 0;    // first sample of the block being rendered
+    volatile uint32_t blockStartUs = 0;    // micros() at that point, to stamp incoming MIDI
+    float    bpm            = 120.0f;
+    double   beat           = 0.0;         // beat position at samplePos
+    float    beatsPerSample = 120.0f / (60.0f * SAMPLE_RATE);
+    bool     running        = false;
+
+    // sample position of an event happening now, called from the MIDI task
+    inline uint32_t stamp(uint32_t nowUs, uint32_t blockLen) const {
+        const uint32_t pos = samplePos;
+        uint32_t off = (uint32_t)((uint64_t)(nowUs - blockStartUs) * SAMPLE_RATE / 1000000ULL);
+        if (off > blockLen) off = blockLen;
+        return pos + off;
+    }
+};
+
+// ---------------------------------
+// Multi-timbral part
+// ---------------------------------
+constexpr uint8_t RDX_PART_OMNI = 16;   // listens on every channel
+
+struct RDX_Part {
+    RDX_Patch patch;
+    bool      enabled  = false;
+    uint8_t   channel  = RDX_PART_OMNI;  // 0..15 = MIDI channel 1..16
+    uint8_t   volume   = 127;
+    uint8_t   keyLow   = 0;              // key range, splits are parts with adjacent ranges
+    uint8_t   keyHigh  = 127;
+    uint8_t   reserve  = 0;              // voices other parts can't steal from this one
+    uint8_t   priority = RDX_PRIO_LAST;  // RDX_NotePriority
+    int       pitchbend = 0;             // last bend on the part's channel, 0-centered
+    float     pitchbendSemitones = 0.0f; // that bend through the patch's PB range
+    float     portaTimeS = 0.06f;        // from the patch's portamento time
+
+    inline bool accepts(uint8_t ch, uint8_t note) const {   // ch 0..15
+        return enabled && (channel == RDX_PART_OMNI || channel == ch) && note >= keyLow && note <= keyHigh;
+    }
+    inline bool listens(uint8_t ch) const {
+        return enabled && (channel == RDX_PART_OMNI || channel == ch);
+    }
+};
+
 // The main state structure.
 struct SynthState {
     RDX_System      system;
     RDX_Patch       storedPatch;
-    RDX_Patch       workingPatch;
+    RDX_Part        parts[RDX_PARTS];
     RDX_Controls    controls;
+    RDX_AudioConfig audio;
+    RDX_Transport   transport;
+
+    SynthState() { parts[0].enabled = true; }
+
+    // part 0: what the GUI, SysEx editor and FX follow
+    inline RDX_Patch& workingPatch() { return parts[0].patch; }
 };
 
 static inline bool patchToSyx( RDX_Patch& patch, uint8_t* out, uint32_t& outLen, uint8_t midiCh=0, uint8_t patchNum=0) {
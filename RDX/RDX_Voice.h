@@ -2,6 +2,7 @@
 #pragma once
 #include <Arduino.h>
 #include <cmath>
+#include <atomic>
 #include "RDX_Types.h"
 #include "RDX_Constants.h"
 #include "RDX_Operator.h"
@@ -10,6 +11,8 @@
 #include "RDX_State.h"
 #include "RDX_LFO.h"
 
+static_assert(MIN_BLOCK_LEN % RDX_MOD_RATE == 0, "control-rate steps must line up with blocks");
+
 
 class  RDX_Voice {
 public:
@@ -19,6 +22,8 @@ public:
             op.reset();
         }
         peg_.reset();
+        stealPending_.store(false, std::memory_order_relaxed);
+        justAllocated_ = false;
     }
 
 inline void noteOn(uint8_t note, uint8_t vel) {
@@ -27,9 +32,9 @@ inline void noteOn(uint8_t note, uint8_t vel) {
     velocity_ = vel;
     active_ = true;
 
-    const float noteTarget = float(note) + patch_.common.transpose - 64.f;
-    const bool monoMode   = (patch_.common.monoPoly != RDX_MODE_POLY);
-    const bool monoFull   = (patch_.common.monoPoly == RDX_MODE_MONO_FULL);
+    const float noteTarget = float(note) + patch_->common.transpose - 64.f;
+    const bool monoMode   = (patch_->common.monoPoly != RDX_MODE_POLY);
+    const bool monoFull   = (patch_->common.monoPoly == RDX_MODE_MONO_FULL);
     const bool overlapping = gate_;  // another note held
 
     bool doRetrig = false;
@@ -56,7 +61,7 @@ inline void noteOn(uint8_t note, uint8_t vel) {
         portamentoStartNote_  = currentNoteSemitone_;
         portamentoTargetNote_ = noteTarget;
         portamentoPos_        = 0.f;
-        portamentoInc_        = 1.f / (ctl_.portaTimeS * (float)sampleRate_);
+        portamentoInc_        = 1.f / (portaTimeS_ * (float)sampleRate_);
     } else {
         portamentoStartNote_  = noteTarget;
         portamentoTargetNote_ = noteTarget;
@@ -64,7 +69,7 @@ inline void noteOn(uint8_t note, uint8_t vel) {
         portamentoInc_        = 0.f;
     }
 
-    if (monoFull && !overlapping && patch_.common.portaTime == 0 ) {
+    if (monoFull && !overlapping && patch_->common.portaTime == 0 ) {
         // full mono, isolated note, zero portamento → hard phase reset
         portamentoStartNote_  = noteTarget;
         portamentoTargetNote_ = noteTarget;
@@ -83,8 +88,10 @@ inline void noteOn(uint8_t note, uint8_t vel) {
     if (doRetrig) {
         noteOnBaseNote_      = noteTarget;
         currentNoteSemitone_ = noteTarget;
+        modSnap_ = true;      // no ramp from the previous note's pitch
+        modCount_ = 0;
 
-        peg_.initPEG(patch_.common.pegRate, patch_.common.pegLevel);
+        peg_.initPEG(patch_->common.pegRate, patch_->common.pegLevel);
         syncLFO();
         peg_.gate(true);
 
@@ -102,6 +109,84 @@ inline void noteOn(uint8_t note, uint8_t vel) {
 }
 
 inline void setJustAllocated() { justAllocated_ = true; }
+inline bool isJustAllocated() const { return justAllocated_; }
+
+// note-on order, for oldest-note stealing
+inline void setStamp(uint32_t s) { stamp_ = s; }
+inline uint32_t stamp() const { return stamp_; }
+
+// Stolen while sounding: the note is taken over right away (so note-off/sustain find it),
+// the audio task fades the old sound out and then calls startSteal().
+inline void queueSteal(uint8_t part, RDX_Patch* patch, uint8_t note, uint8_t vel, float pan, uint8_t layers) {
+    stealLayers_ = layers;
+    stealPart_ = part;
+    stealPatch_ = patch;
+    stealVel_ = vel;
+    stealPan_ = pan;
+    note_ = note;
+    gate_ = true;
+    sustained_ = false;
+    stealPending_.store(true, std::memory_order_release);     // the payload above goes with it
+}
+inline bool stealPending() const { return stealPending_.load(std::memory_order_acquire); }
+
+inline void startSteal() {
+    const uint8_t part = stealPart_;
+    RDX_Patch* patch = stealPatch_;
+    const uint8_t vel = stealVel_;
+    const uint8_t layers = stealLayers_;
+    const float pan = stealPan_;
+    stealPending_.store(false, std::memory_order_release);    // taken, the slot can be queued again
+    const bool held = gate_;        // key may have been released during the fade
+    const bool sustained = sustained_;
+    if (part != part_ || patch != patch_) {
+        bindPart(part, patch);
+        cacheParams();
+    }
+    setUnison(layers, ctl_.unisonDetune);
+    setPan(pan);
+    gate_ = false;                  // no glide from the stolen note
+    noteOn(note_, vel);
+    if (!held) {
+        if (sustained) {
+            gate_ = false;
+            sustained_ = true;
+        } else {
+            noteOff();
+        }
+    }
+}
+
+// switches the voice (and its operators) over to a part's patch; the caller marks it dirty
+inline void bindPart(uint8_t part, RDX_Patch* patch) {
+    part_ = part;
+    patch_ = patch;
+    for (int i = 0; i < 4; ++i) ops_[i].bindParams(&patch->ops[i]);
+}
+inline uint8_t part() const { return part_; }
+
+// pan -1 (left) .. +1 (right), constant power law; unison layers are spread around it by ctl_.unisonSpread
+inline void setPan(float pan) {
+    pan = fclamp(pan, -1.0f, 1.0f);
+    pan_ = pan;
+    const float a = (pan + 1.0f) * 0.25f * (float)M_PI;
+    panL_ = cosf(a) * (float)M_SQRT2;  // unity at center, same loudness as the mono render
+    panR_ = sinf(a) * (float)M_SQRT2;
+    if (layers_ == 1) {
+        layerL_[0] = panL_;
+        layerR_[0] = panR_;
+        return;
+    }
+    for (int l = 0; l < layers_; ++l) {
+        const float lp = fclamp(pan + ctl_.unisonSpread * (2.f * l / (float)(layers_ - 1) - 1.f), -1.0f, 1.0f);
+        const float la = (lp + 1.0f) * 0.25f * (float)M_PI;
+        layerL_[l] = cosf(la) * (float)M_SQRT2 * layerNorm_;
+        layerR_[l] = sinf(la) * (float)M_SQRT2 * layerNorm_;
+    }
+}
+inline float getPan() const { return pan_; }
+inline float panL() const { return panL_; }
+inline float panR() const { return panR_; }
 
 inline void noteOff() {
     gate_ = false;       // key released
@@ -118,12 +203,28 @@ inline void noteOff() {
     sustained_ = false;
 }
 
+// per sample: ramps the control-rate values, pitch ramps live in the operators
 inline IRAM_ATTR __attribute__((always_inline)) void updateMods() {
-    float peg_value = peg_.processPEG();
+    if (modCount_ == 0) controlMods();
+    --modCount_;
+    if (ampRamping_) {
+        for (int i = 0; i < 4; ++i) ampMod_[i] += ampModInc_[i];
+    }
+}
+
+// every RDX_MOD_RATE samples: PEG, portamento and LFO moved to the end of the step,
+// per-operator pitch ratio and AM computed there and ramped to linearly
+inline IRAM_ATTR __attribute__((always_inline)) void controlMods() {
+    constexpr float n = (float)RDX_MOD_RATE;
+    constexpr float divN = 1.0f / RDX_MOD_RATE;
+    modCount_ = RDX_MOD_RATE;
+
+    float peg_value = peg_.processPEG((uint32_t)RDX_MOD_RATE);
+    bool ampRamping = false;
 
     // --- Portamento ---
     if (portamentoPos_ < 1.f) {
-        portamentoPos_ += portamentoInc_;
+        portamentoPos_ += portamentoInc_ * n;
         if (portamentoPos_ >= 1.f) {
             portamentoPos_ = 1.f;
             currentNoteSemitone_ = portamentoTargetNote_;
@@ -135,9 +236,9 @@ inline IRAM_ATTR __attribute__((always_inline)) void updateMods() {
     const float portaOffsetSemitones = currentNote - noteOnBaseNote_;
 
     // --- LFO + mod sources ---
-    lfoValue_ += lfoIncrement_;
+    lfoValue_ += lfoIncrement_ * n;
     const float modWheelLfo = lfoValue_ * ctl_.modWheelFactor;
-    const float pitchBend = ctl_.pitchbendSemitones;
+    const float pitchBend = parts_[part_].pitchbend * pbScale_;
     const float pmMult = lfoValue_ * pmDepth_;
     //const float lfoNorm = lfoValue_ * MIDI_NORM;
     for (int i = 0; i < 4; ++i) {
@@ -145,15 +246,30 @@ inline IRAM_ATTR __attribute__((always_inline)) void updateMods() {
         phaseMod += peg_value * pegEnable_[i];
         phaseMod += pmMult * lfoPMDEnable_[i];
         phaseMod += modWheelLfo;
-        phaseMod_[i] = phaseMod + pitchBend + portaOffsetSemitones;
+        // static pitch (no vibrato, PEG done, no bend/glide) skips the LUT
+        const float semis = phaseMod + pitchBend + portaOffsetSemitones;
+        const float ratio = (semis == pitchSemis_[i] && !modSnap_) ? pitchRatio_[i] : semitonesToRatio(semis);
+        pitchSemis_[i] = semis;
 
+        float amp = 1.0f;
         if (lfoAMD_[i] > 0) {
-            ampMod_[i] = 1.0f + AM_DEPTH[lfoAMD_[i]] * (lfoValue_*2.0f - 1.0f) - modWheelLfo;
-            fclamp(ampMod_[i], 0.f, 1.f);
+            amp = 1.0f + AM_DEPTH[lfoAMD_[i]] * (lfoValue_*2.0f - 1.0f) - modWheelLfo;
+            amp = fclamp(amp, 0.f, 1.f);
+        }
+
+        if (modSnap_) {
+            ops_[i].setPitch(ratio, 0.f, layers_);
+            ampMod_[i] = amp;
+            ampModInc_[i] = 0.f;
         } else {
-            ampMod_[i] = 1.0f;
+            ops_[i].setPitch(pitchRatio_[i], (ratio - pitchRatio_[i]) * divN, layers_);
+            ampModInc_[i] = (amp - ampMod_[i]) * divN;
+            ampRamping |= (ampModInc_[i] != 0.f);
         }
+        pitchRatio_[i] = ratio;     // where this step ends
     }
+    ampRamping_ = ampRamping;
+    modSnap_ = false;
 }
 
     
@@ -201,15 +317,22 @@ inline IRAM_ATTR __attribute__((always_inline)) void updateMods() {
 
 
     inline void syncLFO() {
-        lfo_.init(patch_.common.lfoSpeed, patch_.common.lfoDelay, (RDX_LFO::Waveform)patch_.common.lfoWave);
-        algorithm_ = patch_.common.algorithm;
+        lfo_.init(patch_->common.lfoSpeed, patch_->common.lfoDelay, (RDX_LFO::Waveform)patch_->common.lfoWave);
+        algorithm_ = patch_->common.algorithm;
     }
 
 
-    inline  IRAM_ATTR __attribute__((always_inline)) void  updateLfo() {
-        lfo_.updateState();          // advance once per block
+    inline  IRAM_ATTR __attribute__((always_inline)) void  updateLfo(uint32_t n = DMA_BUFFER_LEN) {
+        const uint8_t sync = ctl_.lfoSync;
+        if (sync <= TEMPO_1_8D && tr_.running) {
+            lfo_.syncTo(tr_.beat, tr_.beatsPerSample, TEMPO_DIV_BEATS[sync]);
+        } else {
+            lfo_.unsync();
+        }
+        lfo_.updateState(n);          // advance once per block
         lfoValue_ = lfo_.getValue();      // cache start-of-block value
         lfoIncrement_ = lfo_.getIncrement(); // cache per-sample increment
+        modCount_ = 0;                    // control steps start with the block
     }
 
 
@@ -231,103 +354,129 @@ inline IRAM_ATTR __attribute__((always_inline)) void updateMods() {
     }
 
 
+    // one sample, unison layers summed
     inline IRAM_ATTR __attribute__((always_inline, hot)) float step() {
      //   if (!ops_[0].isActive()) {return 0.0f  ;}
         updateMods();
+        for (int k = 0; k < 4; ++k) ops_[k].tick();
+        if (layers_ == 1) return algo();
+        float sum = 0.f;
+        for (int l = 0; l < layers_; ++l) {
+            if (l) for (int k = 0; k < 4; ++k) ops_[k].selectLayer(l);
+            sum += algo();
+        }
+        return sum * layerNorm_;
+    }
+
+    // one sample into L/R, each unison layer at its own pan (panL()/panR() already applied)
+    inline IRAM_ATTR __attribute__((always_inline, hot)) void stepStereo(float& left, float& right) {
+        updateMods();
+        for (int k = 0; k < 4; ++k) ops_[k].tick();
+        float l0 = 0.f, r0 = 0.f;
+        for (int l = 0; l < layers_; ++l) {
+            if (l) for (int k = 0; k < 4; ++k) ops_[k].selectLayer(l);
+            const float s = algo();
+            l0 += s * layerL_[l];
+            r0 += s * layerR_[l];
+        }
+        left = l0;
+        right = r0;
+    }
+
+    inline uint8_t layers() const { return layers_; }
+
+    // Unison stack for the next note: layers spread evenly over +-cents, taken by the
+    // voice as a whole (allocated and stolen as one). Call before setPan().
+    inline void setUnison(uint8_t layers, float cents) {
+        if (layers < 1) layers = 1;
+        if (layers > MAX_VOICES_PER_NOTE) layers = MAX_VOICES_PER_NOTE;
+        layers_ = layers;
+        layerNorm_ = 1.0f / sqrtf((float)layers);
+        for (int l = 0; l < layers; ++l) {
+            const float d = (layers > 1) ? cents * 0.01f * (2.f * l / (float)(layers - 1) - 1.f) : 0.f;
+            const float ratio = semitonesToRatio(d);
+            for (int k = 0; k < 4; ++k) ops_[k].setLayerRatio(l, ratio);
+        }
+    }
+
+private:
+    inline IRAM_ATTR __attribute__((always_inline, hot)) float algo() {
         switch(algorithm_) {
             case 0: // 4->3->2->1
                 return (ampMod_[0] * ops_[0].compute(
                             ampMod_[1] * ops_[1].compute(
                                 ampMod_[2] * ops_[2].compute(
-                                    ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]) , phaseMod_[2]
-                                ) , phaseMod_[1]
-                            ) , phaseMod_[0]
-                        ));
+                                    ampMod_[3] * ops_[3].compute(0.0f)))));
 
             case 1: // (4+3)->2->1
                 return (ampMod_[0] * ops_[0].compute(
                             ampMod_[1] * ops_[1].compute(
-                                ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]) +
-                                ampMod_[2] * ops_[2].compute(0.0f, phaseMod_[2]),
-                                phaseMod_[1]
-                            ) , phaseMod_[0]
-                        ));
+                                ampMod_[3] * ops_[3].compute(0.0f) +
+                                ampMod_[2] * ops_[2].compute(0.0f))));
 
             case 2: // 3->2 ; (2+4)->1
                 return (ampMod_[0] * ops_[0].compute(
                           ampMod_[1] * ops_[1].compute(
-                            ampMod_[2] * ops_[2].compute(0.0f, phaseMod_[2]) , phaseMod_[1] 
-                          )
-                        + ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]) 
-                        , phaseMod_[0]
-                        ));
+                            ampMod_[2] * ops_[2].compute(0.0f))
+                        + ampMod_[3] * ops_[3].compute(0.0f)));
 
             case 3: { // 4->(2,3) ; (2+3)->1
-                const float m4 = ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]);
+                const float m4 = ampMod_[3] * ops_[3].compute(0.0f);
                 return (ampMod_[0] * ops_[0].compute(
-                            ampMod_[1] * ops_[1].compute(m4 , phaseMod_[1]) +
-                            ampMod_[2] * ops_[2].compute(m4 , phaseMod_[2]),
-                            phaseMod_[0]
-                        ));
+                            ampMod_[1] * ops_[1].compute(m4) +
+                            ampMod_[2] * ops_[2].compute(m4)));
             }
 
             case 4: // (2+3+4)->1
                 return (ampMod_[0] * ops_[0].compute(
-                            ampMod_[1] * ops_[1].compute(0.0f, phaseMod_[1]) +
-                            ampMod_[2] * ops_[2].compute(0.0f, phaseMod_[2]) +
-                            ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]),
-                            phaseMod_[0]
-                        ));
+                            ampMod_[1] * ops_[1].compute(0.0f) +
+                            ampMod_[2] * ops_[2].compute(0.0f) +
+                            ampMod_[3] * ops_[3].compute(0.0f)));
 
             case 5: // 4->3->2 ; 1||2
-                return ((ampMod_[0] * ops_[0].compute(0.0f, phaseMod_[0]) +
+                return ((ampMod_[0] * ops_[0].compute(0.0f) +
                         ampMod_[1] * ops_[1].compute(
                             ampMod_[2] * ops_[2].compute(
-                                ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]) , phaseMod_[2]
-                            ) , phaseMod_[1]
-                        )));
+                                ampMod_[3] * ops_[3].compute(0.0f)))));
 
             case 6: { // 4->3 ; 3->(2,1) ; 1||2
                 const float m3 = ampMod_[2] * ops_[2].compute(
-                                    ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]) , phaseMod_[2]);
-                return ((ampMod_[0] * ops_[0].compute(m3 , phaseMod_[0]) +
-                        ampMod_[1] * ops_[1].compute(m3 , phaseMod_[1])));
+                                    ampMod_[3] * ops_[3].compute(0.0f));
+                return ((ampMod_[0] * ops_[0].compute(m3) +
+                        ampMod_[1] * ops_[1].compute(m3)));
             }
 
             case 7: // 2->1 ; 4->3 ; 1||3
                 return ((ampMod_[0] * ops_[0].compute(
-                            ampMod_[1] * ops_[1].compute(0.0f, phaseMod_[1]) , phaseMod_[0]
-                        ) +
+                            ampMod_[1] * ops_[1].compute(0.0f)) +
                         ampMod_[2] * ops_[2].compute(
-                            ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]) , phaseMod_[2]
-                        )));
+                            ampMod_[3] * ops_[3].compute(0.0f))));
 
             case 8: { // 4->(1,2,3) ; OUT=1+2+3
-                const float m4 = ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]);
-                return ((ampMod_[0] * ops_[0].compute(m4 , phaseMod_[0]) +
-                        ampMod_[1] * ops_[1].compute(m4 , phaseMod_[1]) +
-                        ampMod_[2] * ops_[2].compute(m4 , phaseMod_[2])));
+                const float m4 = ampMod_[3] * ops_[3].compute(0.0f);
+                return ((ampMod_[0] * ops_[0].compute(m4) +
+                        ampMod_[1] * ops_[1].compute(m4) +
+                        ampMod_[2] * ops_[2].compute(m4)));
             }
 
             case 9: { // 4->(2,3) ; OUT=1+2+3
-                const float m4 = ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]);
-                return ((ampMod_[0] * ops_[0].compute(0.0f, phaseMod_[0]) +
-                        ampMod_[1] * ops_[1].compute(m4 , phaseMod_[1]) +
-                        ampMod_[2] * ops_[2].compute(m4 , phaseMod_[2])));
+                const float m4 = ampMod_[3] * ops_[3].compute(0.0f);
+                return ((ampMod_[0] * ops_[0].compute(0.0f) +
+                        ampMod_[1] * ops_[1].compute(m4) +
+                        ampMod_[2] * ops_[2].compute(m4)));
             }
 
             case 10: // 4->3 ; OUT=1+2+3
-                return ((ampMod_[0] * ops_[0].compute(0.0f, phaseMod_[0]) +
-                        ampMod_[1] * ops_[1].compute(0.0f, phaseMod_[1]) +
+                return ((ampMod_[0] * ops_[0].compute(0.0f) +
+                        ampMod_[1] * ops_[1].compute(0.0f) +
                         ampMod_[2] * ops_[2].compute(
-                            ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3]) , phaseMod_[2]
-                        )));
+                            ampMod_[3] * ops_[3].compute(0.0f))));
 
             case 11: // 1||2||3||4
-                return ((ampMod_[0] * ops_[0].compute(0.0f, phaseMod_[0]) +
-                        ampMod_[1] * ops_[1].compute(0.0f, phaseMod_[1]) +
-                        ampMod_[2] * ops_[2].compute(0.0f, phaseMod_[2]) +
-                        ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3])));
+                return ((ampMod_[0] * ops_[0].compute(0.0f) +
+                        ampMod_[1] * ops_[1].compute(0.0f) +
+                        ampMod_[2] * ops_[2].compute(0.0f) +
+                        ampMod_[3] * ops_[3].compute(0.0f)));
 
             default: {
                 vTaskDelay(1); // invalid RDX_State ?
@@ -336,18 +485,40 @@ inline IRAM_ATTR __attribute__((always_inline)) void updateMods() {
         }
     }
 
+public:
     inline void cacheParams() {
- //       ctl_.portaTimeS = patch_.common.portaTime * 0.0037f ; // 71ms at 19, 469ms at 127
-        ctl_.portaTimeS = AM_DEPTH[patch_.common.portaTime] * 2.5f ; // 71ms at 19, 2500ms at 127
-        algorithm_          = patch_.common.algorithm;
-        pmDepth_            = PM_DEPTH[patch_.common.lfoPMD];
-        lfo_.setWaveform((RDX_LFO::Waveform)patch_.common.lfoWave);
-        lfo_.setRate(patch_.common.lfoSpeed);
-        for (int i = 0; i < 4; ++i) {
-            ops_[i].updateParams();
-            pegEnable_[i]       = patch_.ops[i].pegEnable;
-            lfoPMDEnable_[i]    = patch_.ops[i].lfoPMDEnable;
-            lfoAMD_[i]          = patch_.ops[i].lfoAMD;
+        applyUpdates(RDX_UPD_COMMON_ALL, 0xFFFFFFFF);
+    }
+
+    // common: RDX_CommonUpdate bits, ops: RDX_OpUpdate bits, 8 per operator (op0 in the low byte)
+    inline void applyUpdates(uint8_t common, uint32_t ops) {
+        if (common & RDX_UPD_PORTA) {
+            portaTimeS_ = AM_DEPTH[patch_->common.portaTime] * 2.5f ; // 71ms at 19, 2500ms at 127
+        }
+        if (common & RDX_UPD_PB) {
+            pbScale_ = (float)(patch_->common.pbRange - 64) * (1.0f / 8192.0f); // semitones per PB step, parts have their own range
+        }
+        if (common & RDX_UPD_ALGO) {
+            algorithm_ = patch_->common.algorithm;
+        }
+        if (common & RDX_UPD_LFO) {
+            pmDepth_ = PM_DEPTH[patch_->common.lfoPMD];
+            lfo_.setWaveform((RDX_LFO::Waveform)patch_->common.lfoWave);
+            lfo_.setRate(patch_->common.lfoSpeed);
+            lfo_.setDelay(patch_->common.lfoDelay);
+        }
+        if (common & RDX_UPD_PEG) {
+            peg_.initPEG(patch_->common.pegRate, patch_->common.pegLevel, false);
+        }
+        for (int i = 0; i < 4; ++i, ops >>= 8) {
+            const uint8_t what = ops & 0xFF;
+            if (!what) continue;
+            ops_[i].applyUpdates(what);
+            if (what & RDX_UPD_OP_MOD) {
+                pegEnable_[i]       = patch_->ops[i].pegEnable;
+                lfoPMDEnable_[i]    = patch_->ops[i].lfoPMDEnable;
+                lfoAMD_[i]          = patch_->ops[i].lfoAMD;
+            }
         }
     }
 
@@ -368,6 +539,14 @@ private:
     float noteOnBaseNote_       = 0.f;   // absolute semitone that ops were set with
     float currentNoteSemitone_ = 0.0f;
     bool justAllocated_         = false; // score modifier
+    uint32_t stamp_             = 0;
+    // pending steal
+    std::atomic<bool> stealPending_{false};   // set by the MIDI task after the payload below
+    uint8_t     stealPart_      = 0;
+    uint8_t     stealVel_       = 0;
+    uint8_t     stealLayers_    = 1;
+    float       stealPan_       = 0.f;
+    RDX_Patch*  stealPatch_     = nullptr;
     float sampleRate_ = (float)SAMPLE_RATE;
 
     RDX_Operator ops_[4] = { // a bit of verbose so the ops would know who they are on creation, and could have a firm ref to their params structs
@@ -378,10 +557,19 @@ private:
     };
 
     RDX_PEG             peg_;             // per-voice PEG
-    RDX_Patch&          patch_          = RDX_State::getState().workingPatch; 
+    RDX_Patch*          patch_          = &RDX_State::getState().workingPatch();
+    uint8_t             part_           = 0;
     RDX_Controls&       ctl_            = RDX_State::getState().controls;
-    float               phaseMod_[4]    = {0.0f, 0.0f, 0.0f, 0.0f};         // per-operator PM input
+    const RDX_Part*     parts_          = RDX_State::getState().parts;
+    const RDX_Transport& tr_            = RDX_State::getState().transport;
+    float               pitchRatio_[4]  = {1.0f, 1.0f, 1.0f, 1.0f};         // per-operator PM as a frequency ratio, end of the control step
+    float               pitchSemis_[4]  = {0.0f, 0.0f, 0.0f, 0.0f};         // the same in semitones, to spot a static pitch
     float               ampMod_[4]      = {1.0f, 1.0f, 1.0f, 1.0f};         // per-operator AM input
+    // control-rate ramps
+    float               ampModInc_[4]   = {0.0f, 0.0f, 0.0f, 0.0f};
+    bool                ampRamping_     = false;
+    uint32_t            modCount_       = 0;     // samples left in the current control step
+    bool                modSnap_        = true;  // jump to the next control values instead of ramping
     float               score_ = 0.f;
     uint8_t             note_;
     float               velocity_ = 0.0f;
@@ -392,6 +580,8 @@ private:
     // cached params
     int                 algorithm_          = 0;
     float               pmDepth_            = 0.f;
+    float               portaTimeS_         = 0.06f;
+    float               pbScale_            = 0.f;
     int                 pegEnable_[4]       = {0};
     int                 lfoPMDEnable_[4]    = {0};
     int                 lfoAMD_[4]          = {0};
@@ -401,5 +591,15 @@ private:
     float               lfoValue_ = 0.f;
     float               lfoIncrement_ = 0.f;
     float               portaSemitoneOffset_ = 0.0f;
+
+    // stereo placement
+    float               pan_ = 0.f;
+    // unison
+    uint8_t             layers_ = 1;
+    float               layerNorm_ = 1.f;
+    float               layerL_[MAX_VOICES_PER_NOTE] = {1.f};
+    float               layerR_[MAX_VOICES_PER_NOTE] = {1.f};
+    float               panL_ = 1.f;
+    float               panR_ = 1.f;
 };
 
@@ -1,52 +1,131 @@
 // RDX_VoiceAlloc.h
 
 #pragma once
+#include <atomic>
 #include "RDX_Voice.h"
 #include "RDX_Types.h"
 
+// ======================================================
+// RDX_VoiceRank
+// Free voices and steal order of the shared pool, rebuilt by the audio task
+// once per block so a note-on only has to take the first entry.
+// The steal order is published under a sequence count: the MIDI task copies it
+// with read() and copies again if a rebuild overlapped, it never sees half of one.
+// ======================================================
+struct RDX_VoiceRank {
+    struct Snapshot {
+        uint8_t order[MAX_VOICES];      // sounding voices, best victim first
+        uint8_t num;
+        uint8_t used[RDX_PARTS];        // voices each part holds
+        int8_t  lowest[RDX_PARTS];      // per part, voice playing the lowest / highest note, -1 = none
+        int8_t  highest[RDX_PARTS];
+    };
+
+    std::atomic<uint32_t> freeMask{0xFFFFFFFF};
+
+    // the audio task runs on the other core and never waits here, so a retry is rare and short
+    inline void read(Snapshot& out) const {
+        uint32_t q;
+        do {
+            q = seq_.load(std::memory_order_acquire);
+            out = snap_;
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((q & 1) || seq_.load(std::memory_order_relaxed) != q);
+    }
+
+    inline void update(RDX_Voice* voices, int count, uint8_t stealMode) {
+        uint32_t free = 0;
+        int64_t key[MAX_VOICES];
+        Snapshot s;
+        uint8_t n = 0;
+        uint8_t u[RDX_PARTS] = {};
+        int8_t lo[RDX_PARTS], hi[RDX_PARTS];
+        for (int p = 0; p < RDX_PARTS; ++p) lo[p] = hi[p] = -1;
+
+        for (int i = 0; i < count; ++i) {
+            RDX_Voice& v = voices[i];
+            if (v.isJustAllocated()) continue;      // claimed since the last block
+            if (!v.isActive()) { free |= 1u << i; continue; }
+            const uint8_t p = v.part();
+            u[p]++;
+            if (lo[p] < 0 || v.note() < voices[lo[p]].note()) lo[p] = i;
+            if (hi[p] < 0 || v.note() > voices[hi[p]].note()) hi[p] = i;
+
+            // released voices go first in both modes
+            const bool held = v.isHeld() || v.isSustained();
+            int64_t k = held ? (1LL << 32) : 0;
+            if (stealMode == RDX_STEAL_OLDEST) {
+                k += v.stamp();
+            } else {
+                k += (int64_t)(v.calcScore() * 1024.0f);
+            }
+            // insertion sort, the pool is small
+            int j = n++;
+            while (j > 0 && key[j - 1] > k) {
+                key[j] = key[j - 1];
+                s.order[j] = s.order[j - 1];
+                --j;
+            }
+            key[j] = k;
+            s.order[j] = i;
+        }
+        s.num = n;
+        for (int p = 0; p < RDX_PARTS; ++p) {
+            s.used[p] = u[p];
+            s.lowest[p] = lo[p];
+            s.highest[p] = hi[p];
+        }
+        const uint32_t q = seq_.load(std::memory_order_relaxed);
+        seq_.store(q + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        snap_ = s;
+        seq_.store(q + 2, std::memory_order_release);
+        freeMask.store(free, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint32_t> seq_{0};      // odd while snap_ is being written
+    Snapshot snap_ = {};
+};
+
 // ======================================================
 // RDX_VoiceAllocator
-// Intelligent score-based allocator + mono note stack
+// Ranked allocator + mono note stack
+// One per part: the pool is shared, each part keeps its own mono stack and
+// only touches its own voices on note-off. A part's reserved voices are
+// never stolen by another part.
 // ======================================================
 class RDX_VoiceAllocator {
 public:
 
+    inline void setPart(uint8_t part) { part_ = part; }
 
-    inline IRAM_ATTR __attribute__((always_inline)) int findVoice(RDX_Voice* voices, int count, uint8_t note, uint8_t vel, uint8_t mode) {
+    // voice to play the note on, -1 when note priority keeps it silent (mono)
+    inline IRAM_ATTR __attribute__((always_inline)) int findVoice(RDX_Voice* voices, int count, uint8_t note, uint8_t vel, uint8_t mode, RDX_VoiceRank& rank) {
+        stolen_ = false;
         switch (mode) {
             case RDX_MODE_MONO_FULL:
             case RDX_MODE_MONO_LEGATO:
                 pushNote(note);
+                if (monoActive_ && monoPick() != note) return -1;   // a higher priority note is sounding
                 monoActive_ = true;
-                return 0; // always single voice
+                monoNote_ = note;
+                // single voice, kept while it's still ours
+                if (monoVoice_ >= 0 && monoVoice_ < count && voices[monoVoice_].part() == part_) return monoVoice_;
+                monoVoice_ = findPolyVoice(voices, count, note, rank);
+                return monoVoice_;
             case RDX_MODE_POLY:
             default:
                 break;
         }
 
         // --- polyphonic ---
-        for (int i = 0; i < count; ++i) {
-            if (!voices[i].isActive()) {
-                ESP_LOGD("VA", "Using inactive voice %d", i);
-                return i;
-            }
-        }
-
-        float minScore = 1e9f;
-        int victim = 0;
-        for (int i = 0; i < count; ++i) {
-            float s = voices[i].calcScore();
-            if (s < minScore) { 
-                minScore = s;
-                victim = i;
-            }
-            ESP_LOGD("VA", "  ? voice %d score %f", i, s );
-        }
-        ESP_LOGD("VA", "Using victim voice %d score %f", victim, minScore );
-        voices[victim].setJustAllocated();
-        return victim;
+        return findPolyVoice(voices, count, note, rank);
     }
 
+    // the last findVoice() took a voice that was still sounding
+    inline bool stolen() const { return stolen_; }
+
 
     inline IRAM_ATTR __attribute__((always_inline)) void noteOff(RDX_Voice* voices, int /*count*/, uint8_t note, uint8_t mode) {
 
@@ -54,13 +133,14 @@ public:
             case RDX_MODE_MONO_FULL:
             case RDX_MODE_MONO_LEGATO:
                 popNote(note);
+                if (monoVoice_ < 0 || voices[monoVoice_].part() != part_) return;
                 if (stackSize_ == 0) {
                     monoActive_ = false;
-                    voices[0].noteOff();
-                } else {
-                    // return (glide) to previous note
-                    uint8_t prev = stack_[stackSize_ - 1];
-                    voices[0].noteOn(prev, 100);
+                    voices[monoVoice_].noteOff();
+                } else if (note == monoNote_) {
+                    // return (glide) to the note the priority picks among those still held
+                    monoNote_ = monoPick();
+                    voices[monoVoice_].noteOn(monoNote_, 100);
                 }
                 return;
 
@@ -70,7 +150,7 @@ public:
                 for (int i = 0; i < VOICES; ++i) {
                     RDX_Voice& v = voices[i];
 
-                    if (v.note() == note && v.isActive()) {
+                    if (v.note() == note && v.isActive() && v.part() == part_) {
                         // Key physically released
                         v.setHeld(false);
 
@@ -93,6 +173,7 @@ public:
 
     inline void allSoundOff(RDX_Voice* voices, int count) {
         for (int i = 0; i < count; ++i) {
+            if (voices[i].part() != part_) continue;
             voices[i].setHeld(false);
             voices[i].setSustained(false);
             voices[i].noteOff();
@@ -105,6 +186,7 @@ public:
 
     inline void allNotesOff(RDX_Voice* voices, int count) {
         for (int i = 0; i < count; ++i) {
+            if (voices[i].part() != part_) continue;
             if (!ctl_.sustain) {
                 // no sustain — kill everything
                 voices[i].setSustained(false);
@@ -131,6 +213,81 @@ public:
     
 private:
     RDX_Controls& ctl_ = RDX_State::getState().controls;
+    const RDX_Part* parts_ = RDX_State::getState().parts;
+    uint8_t part_ = 0;
+    int monoVoice_ = -1;
+
+    static inline uint32_t noteCounter_ = 0;  // note-on stamps, shared by all parts
+    bool stolen_ = false;
+
+    inline int take(RDX_Voice* voices, RDX_VoiceRank& rank, int i) {
+        rank.freeMask.fetch_and(~(1u << i), std::memory_order_relaxed);
+        voices[i].setJustAllocated();
+        voices[i].setStamp(++noteCounter_);
+        return i;
+    }
+
+    inline int findPolyVoice(RDX_Voice* voices, int count, uint8_t note, RDX_VoiceRank& rank) {
+        // free voice: lowest set bit; a bit can be stale if the rank was built while we took it
+        uint32_t m = rank.freeMask.load(std::memory_order_acquire);
+        if (count < 32) m &= (1u << count) - 1;
+        while (m) {
+            const int i = __builtin_ctz(m);
+            if (!voices[i].isActive() && !voices[i].isJustAllocated()) {
+                ESP_LOGD("VA", "Using inactive voice %d", i);
+                return take(voices, rank, i);
+            }
+            m &= m - 1;
+        }
+
+        stolen_ = true;
+        RDX_VoiceRank::Snapshot snap;
+        rank.read(snap);
+        // note priority: give up the part's note furthest from what it favours
+        const uint8_t prio = parts_[part_].priority;
+        if (prio != RDX_PRIO_LAST) {
+            const int v = (prio == RDX_PRIO_LOW) ? snap.highest[part_] : snap.lowest[part_];
+            if (v >= 0 && v < count && !voices[v].isJustAllocated() && voices[v].part() == part_) {
+                ESP_LOGD("VA", "Using priority victim voice %d", v);
+                return take(voices, rank, v);
+            }
+        }
+
+        // first in the steal order that isn't under another part's reservation
+        for (int k = 0; k < snap.num; ++k) {
+            const int i = snap.order[k];
+            if (i >= count || voices[i].isJustAllocated()) continue;
+            const uint8_t p = voices[i].part();
+            if (p != part_ && snap.used[p] <= parts_[p].reserve) continue;
+            ESP_LOGD("VA", "Using victim voice %d", i);
+            return take(voices, rank, i);
+        }
+
+        // reserves exceed the pool, or everything was claimed in this block: round robin
+        for (int k = 0; k < count; ++k) {
+            robin_ = (robin_ + 1) % count;
+            if (!voices[robin_].isJustAllocated()) break;
+        }
+        return take(voices, rank, robin_);
+    }
+
+    // the held note that should sound, by the part's priority
+    inline uint8_t monoPick() const {
+        if (stackSize_ == 0) return monoNote_;
+        uint8_t n = stack_[stackSize_ - 1];
+        switch (parts_[part_].priority) {
+            case RDX_PRIO_LOW:
+                for (int i = 0; i < stackSize_; ++i) if (stack_[i] < n) n = stack_[i];
+                break;
+            case RDX_PRIO_HIGH:
+                for (int i = 0; i < stackSize_; ++i) if (stack_[i] > n) n = stack_[i];
+                break;
+            default:
+                break;
+        }
+        return n;
+    }
+    int robin_ = 0;
     // --- mono note stack ---
     static constexpr int MAX_STACK = 12;
     uint8_t stack_[MAX_STACK];
@@ -141,8 +298,8 @@ private:
     bool legatoPending_ = false;
 
     inline void pushNote(uint8_t note) {
+        popNote(note);  // a retriggered key moves to the top
         if (stackSize_ < MAX_STACK) stack_[stackSize_++] = note;
-        monoNote_ = note;
     }
 
     inline void popNote(uint8_t note) {
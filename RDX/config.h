@@ -4,15 +4,45 @@
 
 // ===================== AUDIO ==================================
 #define   DMA_BUFFER_NUM        2     // number of internal DMA buffers
-#define   DMA_BUFFER_LEN        128    // length of each buffer in samples
-#define   CHANNEL_SAMPLE_BYTES  2     // can be 1, 2, 3 or 4 (2 and 4 only supported yet)
+#define   DMA_BUFFER_LEN        128    // length of each buffer in samples (startup default, can be changed at runtime)
+#define   MIN_BLOCK_LEN         32     // runtime block size range, multiples of 16
+#define   MAX_BLOCK_LEN         256
+#define   RDX_MOD_RATE          16     // samples per control-rate step of the voice modulation, divides MIN_BLOCK_LEN
+#define   MAX_DMA_BUFFER_NUM    8
+#define   CHANNEL_SAMPLE_BYTES  2     // 2 (16 bit) or 4 (32 bit slots, 24 significant bits)
+#define   I2S_DIRECT_DMA        0     // 1 = render straight into the DMA buffers the driver hands back (IDF 5.2+)
+#define   AUDIO_INPUT           0     // 1 = full duplex: stereo I2S input on I2S_DIN_PIN goes through the FX with the synth
 #define   SAMPLE_RATE           44100
+#define   RDX_STEREO            1     // 1 = voices are panned into separate L/R buses, 0 = mono render (cheaper)
+#define   RDX_FB_OVERSAMPLE     1     // 1 = operators with feedback run their loop at 2x, 0 = always 1x
+#define   FB_OVERSAMPLE_MIN     0     // feedback values above this get the 2x path
+#define   RDX_STEAL_FADE        64    // samples a stolen voice fades out over before it's retriggered
+#define   RDX_PARTS             4     // multi-timbral parts sharing the voice pool, part 0 drives the FX and the GUI
+#define   RDX_AUDIO_TAP         1     // 1 = the audio task copies a decimated output into RDX_AudioTap for meters and the scope page
+#define   RDX_TAP_DECIM         4     // output samples averaged into one tap sample, divides MIN_BLOCK_LEN
+
+// ===================== FX =====================================
+#define   FX_SLOTS              4     // FX graph slots; slots 0 and 1 follow the patch, the rest are set up at runtime
+#define   FX_DRAM_BUDGET        (200 * 1024)  // bytes of internal RAM all FX scratch buffers may take
+#define   FX_PSRAM_BUDGET       (2 * 1024 * 1024)
+#define   FX_MIN_VOICES         2     // FX CPU budget always leaves time for this many voices
+
+// ===================== PATCHES ================================
+#define   PATCH_INDEX_MAX       10240 // patches the browser can list per folder or dump, 14 bytes each in PSRAM
+#define   PATCH_DIR             "/patches"
+#define   PATCH_READ_AHEAD      16    // patch records read from the folder cache at once
+#define   SDMMC_FREQ_KHZ        40000 // 4-bit SD bus clock, 20000 for long wires
 
 // ===================== MIDI ===================================
 #define   USE_USB_MIDI_DEVICE   1     // definition: the synth appears as a USB MIDI Device "S3 SF2 Synth"
 #define   USE_MIDI_STANDARD     2     // definition: the synth receives MIDI messages via serial 31250 bps
 #define   MIDI_IN_DEV           USE_USB_MIDI_DEVICE     // select the appropriate (one of the above) 
 #define   NUM_MIDI_CHANNELS		16
+#define   SYSEX_DEBUG           0     // 1 = hex dump every SysEx message to the debug log
+#define   MIDI_DRAIN_MAX        128   // max messages handled per MIDI task wake-up
+#define   MIDI_COALESCE_SLOTS   16    // distinct CCs held back per burst, the last value wins
+#define   MIDI_CLOCK_SYNC       1     // 1 = follow incoming MIDI clock, 0 = internal tempo (sent out as MIDI clock)
+#define   MIDI_CLOCK_BPM        120.0f
 
 
 #if defined(CONFIG_IDF_TARGET_ESP32S3)
@@ -90,7 +120,7 @@
 #define ACTIVE_STATE  LOW   // LOW = switch connects to GND, HIGH = switch connects to 3V3
 
 
-//#define USE_SD // where to store patches and configs: comment out to use LittleFS on internal flash
+//#define USE_SD // where to store patches and configs: comment out to use LittleFS on internal flash (SD_MMC pins above)
 
 #ifdef ENABLE_GUI
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include "config.h"
 #include "misc.h"
 #include "src/InputManager/src/mux4067.h"
@@ -7,6 +8,10 @@
 
 extern RDX_Synth synth;
 extern PresetManager pm;
+#ifdef ENABLE_GUI
+#include "src/GUI/UI_InputDefs.h"
+void guiInput(UIInputType type, uint8_t id, int16_t value);   // RDX.ino, queued to the GUI task
+#endif
 
 /*
 // Create multiplexer
@@ -20,40 +25,44 @@ Mux4067stack Mux(27, 14, 12, 13, 32, 33);
 
 
 
-struct TunableParams {
-    float param[4]  = {0.5f, 0.5f, 0.5f, 0.5f};
-};
-TunableParams tunableParams;
-
-enum ParamSel { P_1 = 20, P_2, P_3, P_4};
-ParamSel currentSel = P_1;
-
-
 // Create input manager (pass multiplexer pointer)
 InputManager inputManager(nullptr);
 
+// patch picked in the browser (GUI task), loaded here with the buttons' ones
+static std::atomic<int32_t> patchRequest{-1};
+inline void requestPatch(uint32_t entry) { patchRequest.store((int32_t)entry, std::memory_order_relaxed); }
+
+void rdxRescanPatches();   // RDX.ino, reads the patch folder again off the MIDI task
+
+// encoder edits the focused parameter of the current page
 void onEncoder(int id, int dir) {
-    int cur_id = currentSel - (int)(P_1);
-    cur_id = constrain(cur_id, 0, 3);
-    tunableParams.param[cur_id] = fclamp(tunableParams.param[cur_id] + dir * 0.01f, 0.f, 1.f);
-    ESP_LOGI("CTRL", "param %d: %f", cur_id, tunableParams.param[cur_id]);
+#ifdef ENABLE_GUI
+    guiInput(UIInputType::ENCODER, id, dir);
+#endif
 }
 
 void onButton(int id, MuxButton::btnEvents evt) {
     ESP_LOGI("CTRL", "Button %d event: %d", id, evt);
-    currentSel = (ParamSel)id;
 
     RDX_Patch patch;
+    // hold NEXT: read the patch folder again, the cache doesn't see files edited in place
+    if (evt == MuxButton::EVENT_LONGPRESS && id == 22) rdxRescanPatches();
     if (evt == MuxButton::EVENT_CLICK) {        
-        if (id == 21) {
-            pm.loadPrev(patch);
-            synth.applyPatch(patch);
-            ESP_LOGI("CTRL", "%s", patch.common.voiceName);
-        } else if (id == 22) {
-            pm.loadNext(patch);
+        if (id == 21 || id == 22) {
+            if (!pm.tryLock()) return;      // rescanning
+            if (id == 21) pm.loadPrev(patch);
+            else          pm.loadNext(patch);
+            pm.unlock();
             synth.applyPatch(patch);
             ESP_LOGI("CTRL", "%s", patch.common.voiceName);
         }
+#ifdef ENABLE_GUI
+        // 20/25 move the focus, 23/24 flip the pages
+        else if (id == 20) guiInput(UIInputType::FOCUS, id, 1);
+        else if (id == 25) guiInput(UIInputType::FOCUS, id, -1);
+        else if (id == 23) guiInput(UIInputType::PAGE, id, 1);
+        else if (id == 24) guiInput(UIInputType::PAGE, id, -1);
+#endif
     }
 
 }
@@ -97,6 +106,15 @@ void initControls() {
 
 
 inline void processControls() {
-    // Single call to process all inputs (both multiplexed and direct)
+    // pins are scanned in the input task, this only runs the callbacks for the queued events
     inputManager.process();
-}
\ No newline at end of file
+
+    // kept pending while a rescan holds the patches
+    if (patchRequest.load(std::memory_order_relaxed) >= 0 && pm.tryLock()) {
+        const int32_t req = patchRequest.exchange(-1, std::memory_order_relaxed);
+        RDX_Patch patch;
+        const bool ok = req >= 0 && pm.openByIndex(req, patch);
+        pm.unlock();
+        if (ok) synth.applyPatch(patch);
+    }
+}
\ No newline at end of file
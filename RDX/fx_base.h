@@ -24,6 +24,16 @@ public:
         (void)sampleRate;
         return true;
     }
+    // scratch sizes (in floats) the effect wants from the host, internal RAM and PSRAM respectively
+    virtual uint32_t fastScratchNeeded(int sampleRate) const { (void)sampleRate; return 0; }
+    virtual uint32_t slowScratchNeeded(int sampleRate) const { (void)sampleRate; return 0; }
+
+    // params[0] is the FX type, params[1..2] are the two knobs, same layout as RDX_Common::effects[x]
+    inline void bindParams(const uint8_t* params) { params_ = params; }
+    // optional key signal (e.g. external input), nullptr = the effect follows its own input
+    inline void setSidechain(const float* left, const float* right) { scL_ = left; scR_ = right; }
+    // host tempo and the note length (RDX_TempoDiv) time based effects should lock to, 255 = free running
+    virtual void setTempo(float bpm, uint8_t div) { (void)bpm; (void)div; }
     inline void enable(bool s) { enabled_ = s; }
     inline bool enabled() const { return enabled_; }
 
@@ -32,6 +42,9 @@ protected:
     bool prepared_ = false;
     float sampleRate_ = (float)SAMPLE_RATE;
     uint8_t slotId_ = 0;
+    const uint8_t* params_ = nullptr;
+    const float* scL_ = nullptr;
+    const float* scR_ = nullptr;
 };
 
 
@@ -42,4 +55,3 @@ public:
     }
 
 };
- 
\ No newline at end of file
@@ -38,6 +38,8 @@ public:
         return true;
     }
 
+    uint32_t fastScratchNeeded(int) const override { return MAX_DELAY * 2; }
+
     inline void reset() override {
         if (prepared_) {
             writeIndex_ = 0;
@@ -52,8 +54,8 @@ public:
     inline void processBlock(float* left, float* right, uint32_t frames) override {
         if (unlikely(!prepared_)) return;
  
-        const uint8_t depthParam = st.effects[slotId_][1];
-        const uint8_t rateParam  = st.effects[slotId_][2];
+        const uint8_t depthParam = params_[1];
+        const uint8_t rateParam  = params_[2];
 
         // simple parameter mapping
         // 5–25 ms typical modulation depth
@@ -109,7 +111,6 @@ public:
     }
 
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common ;
     inline IRAM_ATTR float getInterpolatedSample(float* buf, float index) const {
         while (index < 0) index += MAX_DELAY;
         const int idx = (int)index;
@@ -136,4 +137,4 @@ private:
     float lfoPhase_ = 0.0f;
     float lfoFreq_ = 0.5f;
     float baseDelay_ = 0.03f;
-};
\ No newline at end of file
+};
\ No newline at end of file
@@ -52,6 +52,8 @@ public:
         return true;
     }
 
+    uint32_t slowScratchNeeded(int) const override { return MAX_DELAY * 2; }
+
     inline void reset() override {
         if (prepared_) {
             delayIn_ = 0;
@@ -64,8 +66,8 @@ public:
     inline void processBlock(float* left, float* right, uint32_t frames) override {
         if (!prepared_) return;
 
-        setFbParam( st.effects[slotId_][1] ) ;
-        setTimeParam( st.effects[slotId_][2] ); 
+        setFbParam( params_[1] ) ;
+        if (syncDiv_ == DelayTimeDiv::Custom) setTimeParam( params_[2] ); 
 
     //    setMode(modeParam > 63 ? DelayMode::PingPong : DelayMode::Normal);
 
@@ -114,6 +116,15 @@ public:
         setCustomLength(seconds);
     }
 
+    void setTempo(float bpm, uint8_t div) override {
+        syncDiv_ = (div <= (uint8_t)DelayTimeDiv::Dotted8th && bpm > 0.0f) ? (DelayTimeDiv)div : DelayTimeDiv::Custom;
+        if (syncDiv_ != DelayTimeDiv::Custom) {
+            setDelayTime(syncDiv_, bpm);
+        } else {
+            timeParam_ = -1; // back to the knob
+        }
+    }
+
     inline void setCustomLength(float seconds) {
         delayLen_ = fclamp((uint32_t)(seconds * sampleRate_), 1, MAX_DELAY - 1);
     }
@@ -126,20 +137,22 @@ public:
 
     inline void setFbParam(int fb) {
         if (fb == fbParam_) return;
+        fbParam_ = fb;
         setFeedback(fb * MIDI_NORM * 0.5f); // 0 .. 0.5
         MIX = (0.1f + fb * MIDI_NORM * 0.15f); // 0.1 .. 0.25
     }
 
     inline void setTimeParam(int t) {
         if (t == timeParam_) return;
+        timeParam_ = t;
         setCustomLength(DELAY_TIME_MS[t] * 0.001f); // LUTed
     }
 
 private:
-    int timeParam_ = 64;
-    int fbParam_ = 64;
+    int timeParam_ = -1;
+    DelayTimeDiv syncDiv_ = DelayTimeDiv::Custom;
+    int fbParam_ = -1;
     float MIX = 0.14f;
-    RDX_Common& st = RDX_State::getState().workingPatch.common ;
 
 #ifdef BOARD_HAS_PSRAM
     static constexpr int MAX_DELAY = SAMPLE_RATE; // 1 second
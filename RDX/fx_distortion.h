@@ -50,8 +50,8 @@ public:
     inline void processBlock(float* l, float* r, uint32_t n) override {
         if (!enabled_) return;
 
-        setDrive(st.effects[slotId_][1] / 127.0f);
-        setTone(st.effects[slotId_][2] / 127.0f);
+        setDrive(params_[1] / 127.0f);
+        setTone(params_[2] / 127.0f);
 
         const float dg = driveGain_;
         const float mg = makeupGain_;
@@ -71,7 +71,6 @@ public:
     }
 
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
     float driveParam_ = 0.5f;
     float driveGain_  = 1.f;
     float makeupGain_ = 1.f;
@@ -27,6 +27,8 @@ public:
         return true;
     }
 
+    uint32_t fastScratchNeeded(int sampleRate) const override { return ((int)(0.015f * sampleRate) + 4) * 2; }
+
     inline void reset() override {
         if (prepared_) {            
             writeIndex_ = 0;
@@ -47,8 +49,8 @@ public:
     inline void processBlock(float* l, float* r, uint32_t n) override {
         if (!enabled_ || !prepared_) return;
 
-        setDepth(st.effects[slotId_][1] );
-        setRate(st.effects[slotId_][2] );
+        setDepth(params_[1] );
+        setRate(params_[2] );
         updateParams();
 
         for (uint32_t i = 0; i < n; ++i) {
@@ -78,7 +80,6 @@ public:
     }
 
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
     float* delayL_ = nullptr;
     float* delayR_ = nullptr;
     int bufferSize_ = 0;
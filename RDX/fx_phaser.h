@@ -28,11 +28,13 @@ public:
         return true;
     }
 
+    uint32_t fastScratchNeeded(int) const override { return FLANGER_BUF_SIZE * 2; }
+
     inline void processBlock(float* left, float* right, uint32_t frames) override {
         if (!prepared_) return;
 
-        setDepth(st.effects[slotId_][1] );
-        setRate(st.effects[slotId_][2] );
+        setDepth(params_[1] );
+        setRate(params_[2] );
         updatePhaserCoeffs(frames);
         updateFlangerLFO(frames); 
 
@@ -98,7 +100,6 @@ private:
         return 1.f - fabsf(2.f * phase - 1.f); 
     }
 
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
     int sampleRate_ = SAMPLE_RATE;
     bool prepared_ = false;
 
@@ -23,6 +23,7 @@ public:
     {
         (void)scratchSlow; (void)slowSize;
         sampleRate_ = sampleRate; 
+        if (fastSize < fastScratchNeeded(sampleRate)) return false;
 
         float* ptr = scratchFast;
 
@@ -53,6 +54,15 @@ public:
         return true;
     }
 
+    uint32_t fastScratchNeeded(int sampleRate) const override {
+        uint32_t len = 0;
+        for (int ch=0; ch<2; ++ch) {
+            for (int i=0; i<NUM_COMBS; ++i)     len += int((comb_lengths_ms[i] / 1000.f) * sampleRate) + ch * 17;
+            for (int i=0; i<NUM_ALLPASSES; ++i) len += int((allpass_lengths_ms[i] / 1000.f) * sampleRate) + i + ch;
+        }
+        return len;
+    }
+
     inline void reset() override {
         if (!prepared_) return;
         damping_ = 0.3f;
@@ -64,8 +74,8 @@ public:
     inline void processBlock(float* L, float* R, uint32_t n) override {
         if (!prepared_) return;
 
-        float depth = st.effects[slotId_][1] / 127.0f * 0.2f;
-        float time  = st.effects[slotId_][2] / 127.0f;
+        float depth = params_[1] / 127.0f * 0.2f;
+        float time  = params_[2] / 127.0f;
         updateFeedback(time);
 
         for (uint32_t i=0; i<n; ++i) {
@@ -80,7 +90,6 @@ public:
     }
 
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
     float* combBuf_[2][NUM_COMBS];
     int combSize_[2][NUM_COMBS];
     int combIdx_[2][NUM_COMBS];
@@ -17,13 +17,13 @@ public:
     inline void processBlock(float* left, float* right, uint32_t frames) override {
         if (!prepared_) return;
 
-        const uint8_t sensParam = st.effects[slotId_][1];
-        const uint8_t resoParam = st.effects[slotId_][2];
+        const uint8_t sensParam = params_[1];
+        const uint8_t resoParam = params_[2];
         setSens(sensParam);
         setReso(resoParam);
 
         if (recovering_) {
-            recoveryFade_ += 0.0025f;
+            recoveryFade_ += 0.0025f * frames * (1.0f / 128.0f); // tuned per 128-sample block
             if (recoveryFade_ >= 1.f) {
                 recoveryFade_ = 1.f;
                 recovering_ = false;
@@ -42,8 +42,8 @@ public:
             float l = left[i];
             float r = right[i];
 
-            // envelope follower
-            float level = 0.5f * (fabsf(l) + fabsf(r));
+            // envelope follower, keyed by the sidechain if there is one
+            float level = scL_ ? 0.5f * (fabsf(scL_[i]) + fabsf(scR_[i])) : 0.5f * (fabsf(l) + fabsf(r));
             float coeff = (level > env) ? envAttack : envRelease;
             env += (level - env) * coeff;
 
@@ -107,7 +107,6 @@ public:
     }
 
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
 
     static constexpr int STAGES = 6;
     static constexpr float FEEDBACK_BASE = 0.6f;
@@ -0,0 +1,236 @@
+#pragma once
+#include "UI_Page.h"
+#include "UI_Widget.h"
+#include "RDX_PatchIndex.h"
+
+// Patch browser: a name query typed with the encoder, four filters and the hits.
+// The search runs at the top of the page's draw(), so whatever was turned shows
+// up in the same frame. Scrolling the hits loads them, to audition as you go.
+
+// RDX.ino, loaded by the MIDI task like the prev/next buttons
+void rdxLoadPatch(uint32_t entry);
+
+// Encoder turns the letter under the cursor, the blank position past the last letter
+// ends the query. Inside the query there is no blank, FOCUS- removes letters from the
+// end instead. FOCUS+ moves to the next letter (see the page).
+class RDX_QueryWidget : public UI_Widget {
+public:
+  static constexpr int QUERY_LEN = 10;
+
+  RDX_QueryWidget(RDX_PatchFilter& f) : UI_Widget(0, 0, 96, 8), f_(f) {}
+
+  bool isFocusable() const override { return true; }
+
+  void draw(UI_Display& d) override {
+    d.drawText(x_ + 1, y_, ">");
+    d.drawText(x_ + 8, y_, f_.query);
+    d.drawHLine(x_ + 8 + cur_ * (FONT_WIDTH + 1), y_ + 7, FONT_WIDTH);
+  }
+
+  void onInput(uint8_t, int16_t value) override {
+    const int n = sizeof(CHARS) - 1;
+    const char* at = f_.query[cur_] ? strchr(CHARS, f_.query[cur_]) : nullptr;
+    if (f_.query[cur_ + 1]) {
+      // a letter in the middle only turns through the letters, a blank would cut the tail off
+      const int pos = (((at ? at - CHARS : 0) + value) % n + n) % n;
+      f_.query[cur_] = CHARS[pos];
+    } else {
+      const int pos = (((at ? at - CHARS + 1 : 0) + value) % (n + 1) + n + 1) % (n + 1);
+      f_.query[cur_] = pos ? CHARS[pos - 1] : 0;
+    }
+    dirty_ = true;
+  }
+
+  // false when there is nothing to move past or clear, the focus moves on instead
+  inline bool advance() {
+    if (!f_.query[cur_] || cur_ >= QUERY_LEN - 1) return false;
+    ++cur_;
+    dirty_ = true;
+    return true;
+  }
+
+  // clears the letter under the cursor, the tail moves up
+  inline bool back() {
+    if (f_.query[cur_]) memmove(f_.query + cur_, f_.query + cur_ + 1, QUERY_LEN - cur_);
+    else if (cur_ > 0) --cur_;
+    else return false;
+    dirty_ = true;
+    return true;
+  }
+
+private:
+  static constexpr char CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 -";
+
+  RDX_PatchFilter&  f_;
+  int               cur_ = 0;
+};
+
+// one filter, "any" and then the choices
+struct RDX_FilterDef {
+  static constexpr int TEXT_LEN = 12;           // "A" and any int
+  int8_t  count;
+  void    (*set)(RDX_PatchFilter& f, int v);    // v < 0 = any
+  void    (*text)(int v, char* out);            // TEXT_LEN with the NUL, 5 chars fit the box
+};
+
+static const RDX_FilterDef BROWSE_ALGO = { 12,
+  [](RDX_PatchFilter& f, int v) { f.algo = v < 0 ? 0xFF : v; },
+  [](int v, char* t) { if (v < 0) strcpy(t, "A*"); else snprintf(t, RDX_FilterDef::TEXT_LEN, "A%d", v + 1); } };
+static const RDX_FilterDef BROWSE_CARRIERS = { 4,
+  [](RDX_PatchFilter& f, int v) { f.carriers = v < 0 ? 0 : v + 1; },
+  [](int v, char* t) { if (v < 0) strcpy(t, "C*"); else snprintf(t, RDX_FilterDef::TEXT_LEN, "C%d", v + 1); } };
+static const RDX_FilterDef BROWSE_CATEGORY = { PCAT_COUNT,
+  [](RDX_PatchFilter& f, int v) { f.category = v < 0 ? 0xFF : v; },
+  [](int v, char* t) { strcpy(t, v < 0 ? "TYPE" : PCAT_NAMES[v]); } };
+static const RDX_FilterDef BROWSE_TAG = { 8,
+  [](RDX_PatchFilter& f, int v) { f.tags = v < 0 ? 0 : 1 << v; },
+  [](int v, char* t) { strcpy(t, v < 0 ? "TAG" : PTAG_NAMES[v]); } };
+
+class RDX_FilterWidget : public UI_Widget {
+public:
+  RDX_FilterWidget(const RDX_FilterDef& def, RDX_PatchFilter& f, int x, int w) : UI_Widget(x, 8, w, 8), def_(def), f_(f) {}
+
+  bool isFocusable() const override { return true; }
+
+  void draw(UI_Display& d) override {
+    char t[RDX_FilterDef::TEXT_LEN];
+    def_.text(v_, t);
+    d.drawText(x_ + 1, y_, t);
+  }
+
+  void onInput(uint8_t, int16_t value) override {
+    const int n = def_.count + 1;
+    v_ = ((v_ + 1 + value) % n + n) % n - 1;
+    def_.set(f_, v_);
+    dirty_ = true;
+  }
+
+private:
+  const RDX_FilterDef&  def_;
+  RDX_PatchFilter&      f_;
+  int                   v_ = -1;
+};
+
+// number of hits, right aligned
+class RDX_HitCountWidget : public UI_Widget {
+public:
+  RDX_HitCountWidget(const RDX_PatchSearch& s) : UI_Widget(96, 0, 32, 8), s_(s) {}
+
+  void draw(UI_Display& d) override {
+    char t[8];
+    snprintf(t, sizeof(t), "%u", (unsigned)shown_);
+    d.drawText(x_ + w_ - 1 - d.getTextWidth(t), y_, t);
+  }
+
+protected:
+  bool poll() override {
+    if (s_.size() == shown_) return false;
+    shown_ = s_.size();
+    return true;
+  }
+
+private:
+  const RDX_PatchSearch&  s_;
+  uint32_t                shown_ = 0;
+};
+
+// The hits, name and category. Shows its own focus as the selected row.
+class RDX_HitListWidget : public UI_Widget {
+public:
+  static constexpr int ROW_H = 8;
+  static constexpr int ROWS = 6;
+
+  RDX_HitListWidget(const RDX_PatchSearch& s) : UI_Widget(0, 16, 128, ROWS * ROW_H), s_(s) {}
+
+  bool isFocusable() const override { return true; }
+  bool drawsFocus() const override { return true; }
+
+  inline void setIndex(const RDX_PatchIndex* idx) { idx_ = idx; }
+
+  // new hits, back to the top; the first turn after this picks the top hit
+  inline void reset() {
+    sel_ = 0;
+    top_ = 0;
+    picked_ = false;
+    dirty_ = true;
+  }
+
+  void draw(UI_Display& d) override {
+    if (!idx_) return;
+    const uint32_t n = s_.size();
+    for (int r = 0; r < ROWS && top_ + r < n; ++r) {
+      const RDX_PatchInfo& p = (*idx_)[s_[top_ + r]];
+      const int y = y_ + r * ROW_H;
+      d.drawTextBytes(x_ + 1, y, reinterpret_cast<const uint8_t*>(p.name), 10);
+      const char* cat = PCAT_NAMES[p.category < PCAT_COUNT ? p.category : (uint8_t)PCAT_OTHER];
+      d.drawText(x_ + w_ - 1 - d.getTextWidth(cat), y, cat);
+      if (focus_ && top_ + r == sel_) {
+        d.setColor(UIDisplayColor::INVERT);
+        d.fillRect(x_, y, w_, ROW_H);
+        d.setColor(UIDisplayColor::WHITE);
+      }
+    }
+  }
+
+  void onInput(uint8_t, int16_t value) override {
+    const int n = (int)s_.size();
+    if (!n) return;
+    const int s = picked_ ? constrain((int)sel_ + value, 0, n - 1) : 0;
+    if (picked_ && s == (int)sel_) return;
+    picked_ = true;
+    sel_ = s;
+    if (sel_ < top_) top_ = sel_;
+    else if (sel_ >= top_ + ROWS) top_ = sel_ - ROWS + 1;
+    dirty_ = true;
+    rdxLoadPatch(s_[sel_]);
+  }
+
+private:
+  const RDX_PatchSearch&  s_;
+  const RDX_PatchIndex*   idx_ = nullptr;
+  uint32_t                sel_ = 0;
+  uint32_t                top_ = 0;
+  bool                    picked_ = false;  // sel_ was loaded
+};
+
+class RDX_BrowserPage : public UI_Page {
+public:
+  RDX_BrowserPage() {
+    add(&query_);
+    add(&count_);
+    add(&algo_);
+    add(&carriers_);
+    add(&category_);
+    add(&tag_);
+    add(&list_);
+    setFocus(0);
+  }
+
+  inline void setIndex(const RDX_PatchIndex* idx) {
+    index_ = idx;
+    list_.setIndex(idx);
+  }
+
+  // on the query FOCUS+ / FOCUS- type and delete letters until there is nothing to do
+  void focusNext(int dir) override {
+    if (focused() == &query_ && (dir > 0 ? query_.advance() : query_.back())) return;
+    UI_Page::focusNext(dir);
+  }
+
+  bool draw(UI_Display& d) override {
+    if (index_ && search_.update(*index_, filter_)) list_.reset();
+    return UI_Page::draw(d);
+  }
+
+private:
+  const RDX_PatchIndex* index_ = nullptr;
+  RDX_PatchFilter       filter_;
+  RDX_PatchSearch       search_;
+  RDX_QueryWidget       query_    {filter_};
+  RDX_HitCountWidget    count_    {search_};
+  RDX_FilterWidget      algo_     {BROWSE_ALGO, filter_, 0, 20};
+  RDX_FilterWidget      carriers_ {BROWSE_CARRIERS, filter_, 22, 14};
+  RDX_FilterWidget      category_ {BROWSE_CATEGORY, filter_, 38, 34};
+  RDX_FilterWidget      tag_      {BROWSE_TAG, filter_, 74, 34};
+  RDX_HitListWidget     list_     {search_};
+};
@@ -0,0 +1,223 @@
+#pragma once
+#include <vector>
+#include "UI_Page.h"
+#include "UI_Widget.h"
+#include "UI_Label.h"
+#include "RDX_Graph.h"
+#include "RDX_State.h"
+
+// Editor pages: one row per patch byte. Rows read the working patch and redraw when it
+// moves (also on SysEx or CC edits); encoder edits go through synth.setCommonParam() /
+// setOperatorParam(), the same path as a SysEx parameter change.
+
+enum RDX_ParamFmt : uint8_t {
+  FMT_NUM = 0,    // as is
+  FMT_SIGNED,     // centered on 64
+  FMT_PLUS1,      // 1-based
+  FMT_LIST        // names[value - minV]
+};
+
+struct RDX_ParamDef {
+  const char*         name;     // up to 7 chars
+  uint8_t             addr;     // byte in RDX_Common / RDX_OpParams
+  uint8_t             minV;
+  uint8_t             maxV;
+  RDX_ParamFmt        fmt;
+  const char* const*  names;
+};
+
+static const char* const PN_OFFON[]  = { "OFF", "ON" };
+static const char* const PN_MONO[]   = { "POLY", "MONO", "LEGATO" };
+static const char* const PN_WAVE[]   = { "SINE", "TRI", "SAW UP", "SAW DN", "SQUARE", "S&H 8", "S&H" };
+static const char* const PN_FX[]     = { "THRU", "DIST", "T.WAH", "CHORUS", "FLANGE", "PHASER", "DELAY", "REVERB" };
+static const char* const PN_CURVE[]  = { "-LIN", "-EXP", "+EXP", "+LIN" };
+static const char* const PN_FBTYPE[] = { "SAW", "SQR" };
+static const char* const PN_FREQ[]   = { "RATIO", "FIXED" };
+
+static const RDX_ParamDef COMMON_PARAMS[] = {
+  { "Algo",    16,  0,  11, FMT_PLUS1,  nullptr   },
+  { "Mode",    13,  0,   2, FMT_LIST,   PN_MONO   },
+  { "Porta",   14,  0, 127, FMT_NUM,    nullptr   },
+  { "PB Rng",  15, 40,  88, FMT_SIGNED, nullptr   },
+  { "Transp",  12, 40,  88, FMT_SIGNED, nullptr   },
+  { "LFO Wav", 17,  0,   6, FMT_LIST,   PN_WAVE   },
+  { "LFO Spd", 18,  0, 127, FMT_NUM,    nullptr   },
+  { "LFO Dly", 19,  0, 127, FMT_NUM,    nullptr   },
+  { "LFO PMD", 20,  0, 127, FMT_NUM,    nullptr   },
+};
+
+static const RDX_ParamDef PEG_PARAMS[] = {
+  { "Rate 1",  21,  0, 127, FMT_NUM,    nullptr   },
+  { "Rate 2",  22,  0, 127, FMT_NUM,    nullptr   },
+  { "Rate 3",  23,  0, 127, FMT_NUM,    nullptr   },
+  { "Rate 4",  24,  0, 127, FMT_NUM,    nullptr   },
+  { "Level 1", 25, 16, 112, FMT_SIGNED, nullptr   },
+  { "Level 2", 26, 16, 112, FMT_SIGNED, nullptr   },
+  { "Level 3", 27, 16, 112, FMT_SIGNED, nullptr   },
+  { "Level 4", 28, 16, 112, FMT_SIGNED, nullptr   },
+};
+
+static const RDX_ParamDef FX_PARAMS[] = {
+  { "FX1",     29,  0,   7, FMT_LIST,   PN_FX     },
+  { "FX1 P1",  30,  0, 127, FMT_NUM,    nullptr   },
+  { "FX1 P2",  31,  0, 127, FMT_NUM,    nullptr   },
+  { "FX2",     32,  0,   7, FMT_LIST,   PN_FX     },
+  { "FX2 P1",  33,  0, 127, FMT_NUM,    nullptr   },
+  { "FX2 P2",  34,  0, 127, FMT_NUM,    nullptr   },
+};
+
+static const RDX_ParamDef OP_PARAMS[] = {
+  { "On",       0,  0,   1, FMT_LIST,   PN_OFFON  },
+  { "Level",   18,  0, 127, FMT_NUM,    nullptr   },
+  { "Fdbk",    19,  0, 127, FMT_NUM,    nullptr   },
+  { "FB Type", 20,  0,   1, FMT_LIST,   PN_FBTYPE },
+  { "Mode",    21,  0,   1, FMT_LIST,   PN_FREQ   },
+  { "Coarse",  22,  0,  31, FMT_NUM,    nullptr   },
+  { "Fine",    23,  0,  99, FMT_NUM,    nullptr   },
+  { "Detune",  24,  0, 127, FMT_SIGNED, nullptr   },
+  { "VelSens", 17,  0, 127, FMT_NUM,    nullptr   },
+  { "Rate 1",   1,  0, 127, FMT_NUM,    nullptr   },
+  { "Rate 2",   2,  0, 127, FMT_NUM,    nullptr   },
+  { "Rate 3",   3,  0, 127, FMT_NUM,    nullptr   },
+  { "Rate 4",   4,  0, 127, FMT_NUM,    nullptr   },
+  { "Level 1",  5,  0, 127, FMT_NUM,    nullptr   },
+  { "Level 2",  6,  0, 127, FMT_NUM,    nullptr   },
+  { "Level 3",  7,  0, 127, FMT_NUM,    nullptr   },
+  { "Level 4",  8,  0, 127, FMT_NUM,    nullptr   },
+  { "RateScl",  9,  0,   7, FMT_NUM,    nullptr   },
+  { "Scl LD",  10,  0, 127, FMT_NUM,    nullptr   },
+  { "Scl RD",  11,  0, 127, FMT_NUM,    nullptr   },
+  { "Scl LC",  12,  0,   3, FMT_LIST,   PN_CURVE  },
+  { "Scl RC",  13,  0,   3, FMT_LIST,   PN_CURVE  },
+  { "LFO AM",  14,  0, 127, FMT_NUM,    nullptr   },
+  { "LFO PM",  15,  0,   1, FMT_LIST,   PN_OFFON  },
+  { "PEG",     16,  0,   1, FMT_LIST,   PN_OFFON  },
+};
+
+// patch byte of part 0, op < 0 = common
+inline uint8_t rdxParam(int op, uint8_t addr) {
+  const RDX_Patch& p = RDX_State::getState().workingPatch();
+  return op < 0 ? reinterpret_cast<const uint8_t*>(&p.common)[addr] : reinterpret_cast<const uint8_t*>(&p.ops[op])[addr];
+}
+
+// RDX.ino, the synth is not declared yet at this point
+void rdxSetParam(int op, uint8_t addr, uint8_t val);
+
+// "Name    value" row
+class RDX_ParamWidget : public UI_Widget {
+public:
+  RDX_ParamWidget(const RDX_ParamDef& def, int op, int w, int h) : UI_Widget(0, 0, w, h), def_(def), op_(op) {}
+
+  bool isFocusable() const override { return true; }
+
+  void draw(UI_Display& d) override {
+    const int ty = y_ + (h_ - d.getFontHeight()) / 2;
+    d.drawText(x_ + 1, ty, def_.name);
+    char txt[8];
+    const char* val = txt;
+    switch (def_.fmt) {
+      case FMT_SIGNED: snprintf(txt, sizeof(txt), "%+d", (int)shown_ - 64); break;
+      case FMT_PLUS1:  snprintf(txt, sizeof(txt), "%d", (int)shown_ + 1); break;
+      case FMT_LIST:   val = def_.names[(shown_ > def_.maxV ? def_.maxV : shown_) - def_.minV]; break;
+      default:         snprintf(txt, sizeof(txt), "%d", (int)shown_); break;
+    }
+    d.drawText(x_ + w_ - 1 - d.getTextWidth(val), ty, val);
+  }
+
+  void onInput(uint8_t, int16_t value) override {
+    const int v = constrain((int)rdxParam(op_, def_.addr) + value, (int)def_.minV, (int)def_.maxV);
+    if (v != rdxParam(op_, def_.addr)) rdxSetParam(op_, def_.addr, (uint8_t)v);
+  }
+
+protected:
+  bool poll() override {
+    const uint8_t v = rdxParam(op_, def_.addr);
+    if (v == shown_) return false;
+    shown_ = v;
+    return true;
+  }
+
+private:
+  const RDX_ParamDef& def_;
+  int                 op_;
+  int16_t             shown_ = -1;
+};
+
+// amp EG of an operator, or the pitch EG (op < 0)
+class RDX_EGWidget : public UI_Widget {
+public:
+  RDX_EGWidget(int op, int x, int y, int w, int h) : UI_Widget(x, y, w, h), op_(op) {}
+
+  void draw(UI_Display& d) override {
+    drawEG(d, x_, y_, w_, h_, levels_, rates_, op_ < 0 ? UIEnvType::ENV_PITCH : UIEnvType::ENV_AMP, UIEnvMode::ENV_LEVELS);
+  }
+
+protected:
+  bool poll() override {
+    bool moved = false;
+    for (int i = 0; i < 4; ++i) {
+      const uint8_t r = rdxParam(op_, op_ < 0 ? 21 + i : 1 + i);
+      const uint8_t l = rdxParam(op_, op_ < 0 ? 25 + i : 5 + i);
+      moved |= (r != rates_[i]) | (l != levels_[i]);
+      rates_[i] = r;
+      levels_[i] = l;
+    }
+    return moved;
+  }
+
+private:
+  int     op_;
+  uint8_t rates_[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+  uint8_t levels_[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+};
+
+// title row and a scrolling list of parameter rows, with room for a graph on the right
+class RDX_ParamPage : public UI_Page {
+public:
+  static constexpr int ROW_H = 8;
+
+  RDX_ParamPage(const char* title, const RDX_ParamDef* defs, int n, int op = -1, int listW = 128)
+    : title_(0, 0, 128, ROW_H, title) {
+    rows_.reserve(n);
+    for (int i = 0; i < n; ++i) rows_.emplace_back(defs[i], op, listW, ROW_H);
+    for (auto& r : rows_) add(&r);
+    setFocus(0);
+    layout();
+  }
+
+  inline void addGraph(UI_Widget* w) { graphs_.push_back(w); }
+
+  void onEnter() override {
+    UI_Page::onEnter();
+    title_.invalidate();
+    for (auto* g : graphs_) g->invalidate();
+  }
+
+  bool draw(UI_Display& d) override {
+    const int n = (int)rows_.size();
+    if (focus_ < top_) {
+      top_ = focus_;
+      layout();
+    } else if (focus_ >= top_ + visibleRows()) {
+      top_ = focus_ - visibleRows() + 1;
+      layout();
+    }
+    bool drew = title_.refresh(d);
+    for (int i = top_; i < n && i < top_ + visibleRows(); ++i) drew |= rows_[i].refresh(d);
+    for (auto* g : graphs_) drew |= g->refresh(d);
+    return drew;
+  }
+
+private:
+  static constexpr int visibleRows() { return OLED_HEIGHT / ROW_H - 1; }
+
+  inline void layout() {
+    for (int i = top_; i < (int)rows_.size() && i < top_ + visibleRows(); ++i)
+      rows_[i].setPos(0, ROW_H * (1 + i - top_));
+  }
+
+  UI_Label                      title_;
+  std::vector<RDX_ParamWidget>  rows_;
+  std::vector<UI_Widget*>       graphs_;
+  int                           top_ = 0;
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include "UI_Display.h"
+
+// Audio diagnostics drawn from RDX_AudioTap data: scope, spectrum, meters, voice activity.
+
+// fixed-point radix-2 FFT on Q15 tap samples, Hann windowed, stages scaled by 1/2 so nothing overflows
+template <int N>
+class UI_FFT {
+public:
+  static_assert((N & (N - 1)) == 0, "FFT size must be a power of 2");
+
+  UI_FFT() {
+    for (int i = 0; i < N / 2; ++i) {
+      cos_[i] = (int16_t)(cosf(2.f * (float)M_PI * i / N) * 32767.f);
+      sin_[i] = (int16_t)(sinf(2.f * (float)M_PI * i / N) * 32767.f);
+    }
+    for (int i = 0; i < N; ++i) {
+      win_[i] = (int16_t)((0.5f - 0.5f * cosf(2.f * (float)M_PI * i / (N - 1))) * 32767.f);
+    }
+  }
+
+  // N samples in, N/2 bin magnitudes out (alpha-max-plus-beta-min)
+  void magnitudes(const int16_t* in, uint16_t* mag) {
+    for (int i = 0; i < N; ++i) {
+      const int j = reverse(i);
+      re_[j] = ((int32_t)in[i] * win_[i]) >> 15;
+      im_[j] = 0;
+    }
+    for (int len = 2; len <= N; len <<= 1) {
+      const int half = len >> 1;
+      const int step = N / len;
+      for (int i = 0; i < N; i += len) {
+        for (int j = 0; j < half; ++j) {
+          const int32_t wr = cos_[j * step];
+          const int32_t wi = -sin_[j * step];
+          const int a = i + j, b = a + half;
+          const int32_t tr = (re_[b] * wr - im_[b] * wi) >> 15;
+          const int32_t ti = (re_[b] * wi + im_[b] * wr) >> 15;
+          re_[b] = (re_[a] - tr) >> 1;
+          im_[b] = (im_[a] - ti) >> 1;
+          re_[a] = (re_[a] + tr) >> 1;
+          im_[a] = (im_[a] + ti) >> 1;
+        }
+      }
+    }
+    for (int i = 0; i < N / 2; ++i) {
+      const int32_t r = abs(re_[i]), m = abs(im_[i]);
+      mag[i] = (uint16_t)(r > m ? r + (m >> 1) : m + (r >> 1));
+    }
+  }
+
+private:
+  int16_t cos_[N / 2], sin_[N / 2], win_[N];
+  int32_t re_[N], im_[N];
+
+  static int reverse(int i) {
+    int r = 0;
+    for (int b = 1; b < N; b <<= 1) {
+      r = (r << 1) | (i & 1);
+      i >>= 1;
+    }
+    return r;
+  }
+};
+
+// log2 in 1/16 steps (~0.4 dB of amplitude), 0 for silence
+inline int logLevel16(uint32_t v) {
+  if (v == 0) return 0;
+  const int l2 = 31 - __builtin_clz(v);
+  const int frac = l2 >= 4 ? (v >> (l2 - 4)) & 15 : (v << (4 - l2)) & 15;
+  return l2 * 16 + frac;
+}
+
+// free-running scope, triggered on the first rising zero crossing; n >= 2 * w samples
+void drawScope(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h, const int16_t* smp, int n) {
+  display.setBrush(UIDisplayBrush::SOLID);
+  display.setColor(UIDisplayColor::WHITE);
+  int t = 0;
+  for (int i = 1; i < n - w; ++i) {
+    if (smp[i - 1] < 0 && smp[i] >= 0) { t = i; break; }
+  }
+  const int mid = y + h / 2;
+  display.setBrush(UIDisplayBrush::DOTTED);
+  display.drawHLine(x, mid, w);
+  display.setBrush(UIDisplayBrush::SOLID);
+  int oldY = mid - ((int32_t)smp[t] * (h / 2) >> 15);
+  for (int i = 1; i < w; ++i) {
+    const int curY = mid - ((int32_t)smp[t + i] * (h / 2) >> 15);
+    display.drawLine(x + i - 1, oldY, x + i, curY);
+    oldY = curY;
+  }
+}
+
+// bars over the lower bins, bin width = tap rate / (2 * bins)
+void drawSpectrum(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint16_t* mag, int bins) {
+  constexpr int floor16 = 2 * 16;     // ~ -66 dB below full scale after the FFT scaling
+  constexpr int range16 = 11 * 16;
+  display.setBrush(UIDisplayBrush::SOLID);
+  display.setColor(UIDisplayColor::WHITE);
+  const int bw = w / bins;
+  for (int i = 0; i < bins; ++i) {
+    int l = logLevel16(mag[i]) - floor16;
+    if (l <= 0) continue;
+    const int bh = l >= range16 ? h : l * h / range16;
+    display.fillRect(x + i * bw, y + h - bh, bw > 1 ? bw - 1 : 1, bh);
+  }
+}
+
+// horizontal meter, -48..0 dBFS: RMS bar, peak tick
+void drawMeter(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h, float rms, float peak) {
+  auto toX = [w](float v) {
+    if (v <= 0.f) return 0;
+    const float db = 20.f * log10f(v);
+    if (db <= -48.f) return 0;
+    return db >= 0.f ? (int)w : (int)((db + 48.f) * w / 48.f);
+  };
+  display.setBrush(UIDisplayBrush::SOLID);
+  display.setColor(UIDisplayColor::WHITE);
+  const int r = toX(rms);
+  if (r > 0) display.fillRect(x, y, r, h);
+  const int p = toX(peak);
+  if (p > 0) display.drawVLine(x + p - 1, y, h);
+  display.setBrush(UIDisplayBrush::DOTTED);
+  display.drawHLine(x + r, y + h / 2, w - r);
+}
+
+// one bar per voice, 0..1 carrier level
+void drawVoiceBars(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h, const float* level, int n) {
+  display.setBrush(UIDisplayBrush::SOLID);
+  display.setColor(UIDisplayColor::WHITE);
+  const int bw = w / n;
+  for (int i = 0; i < n; ++i) {
+    const int bh = (int)(level[i] * h);
+    display.drawHLine(x + i * bw, y + h - 1, bw - 1);
+    if (bh > 0) display.fillRect(x + i * bw, y + h - bh, bw - 1, bh);
+  }
+}
@@ -6,7 +6,7 @@
 // vertical 0..127 zebra gauge with optional value at the top
 void drawSlider1(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h, int v, int minV, int maxV, bool show_val = true, bool show_sign = true) {
   int c = 0;
-  char txt[5];
+  char txt[12];
   if (show_sign) {
     snprintf(txt, sizeof(txt), "%d", v);
   } else {
@@ -45,7 +45,7 @@ void drawSlider1(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h
 void drawSlider2(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h, int v, int minV, int maxV, bool show_val = true, bool show_sign = true) {
   int c = 0;
   uint8_t sW = 8; 
-  char txt[5];
+  char txt[12];
   if (show_sign) {
     snprintf(txt, sizeof(txt), "%d", v);
   } else {
@@ -102,7 +102,7 @@ void drawSlider3( UI_Display& display,
                   bool show_sign = true
                   ) {
   int c = 0;
-  char txt[5];
+  char txt[12];
   snprintf(txt, sizeof(txt), "%d", abs(v));
   uint8_t textW = 0;
   uint8_t textH = 0;
@@ -143,7 +143,7 @@ void drawSlider3( UI_Display& display,
 // vertical -127..127 slider with center marks
 void drawSlider4(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h, int v, int minV, int maxV, bool show_val = true, bool show_sign = true) {
   int c = 0;
-  char txt[5];
+  char txt[12];
   snprintf(txt, sizeof(txt), "%d", abs(v));
   uint8_t textW = 0;
   uint8_t textH = 0;
@@ -181,7 +181,7 @@ void drawSlider4(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h
 void drawSlider5(UI_Display& display, uint8_t x, uint8_t y, uint8_t w, uint8_t h, int v, int minV, int maxV, bool show_val = true, bool show_sign = true) {
   int c = 0;
   uint8_t sW = w; 
-  char txt[5];
+  char txt[12];
   if (show_sign) {
     snprintf(txt, sizeof(txt), "%+d", v);
   } else {
@@ -1,6 +1,6 @@
 #pragma once
 #include <Arduino.h>
-#include "font_mo.h"
+#include "UI_FontAtlas.h"
 
 enum class UIDisplayBrush : uint8_t {
     SOLID = 0,
@@ -42,9 +42,12 @@ inline void setTextScale(UITextScale s) { textScale_ = s; }
     virtual bool getPixel(int x, int y) const = 0;
     virtual int getWidth() const = 0;
     virtual int getHeight() const = 0;
-    virtual void update() = 0;
+    virtual void update() = 0;      // sends the changed parts of the frame
     virtual void clear() = 0; 
 
+    // next update() resends the whole frame, e.g. after the panel was reset
+    inline void invalidate() { fullRefresh_ = true; markAllDirty(); }
+
     // ---------------- Brush & Color ----------------
     inline void setBrush(UIDisplayBrush b) { brush_ = b; }
     inline UIDisplayBrush getBrush() const { return brush_; }
@@ -79,6 +82,124 @@ protected:
     UIDisplayBrush brush_ = UIDisplayBrush::SOLID;
     UIDisplayColor  color_ = UIDisplayColor::WHITE;
 
+    // ---------------- Dirty regions ----------------
+    // Drawing marks the touched column span of each 8-row page, update() compares that span with
+    // what the panel already shows (shadow_) and sends only the runs of changed bytes. The runs go
+    // out from shadow_, so with an async bus the next frame can be drawn into buf_ meanwhile.
+    static constexpr int MAX_PAGES = 16;    // up to 128 rows
+    static constexpr int RUN_GAP   = 4;     // unchanged bytes sent along rather than re-addressing
+
+    uint8_t* shadow_ = nullptr;
+    uint8_t dirtyLo_[MAX_PAGES] = {};
+    uint8_t dirtyHi_[MAX_PAGES] = {};
+    bool fullRefresh_ = true;
+
+    // driver: set page/column (with the panel's offsets) and write len bytes of one page
+    virtual void writeSpan(uint8_t page, uint8_t col, const uint8_t* data, size_t len) = 0;
+
+    inline void markDirty(int col, int y) { markDirtyPage(col, y >> 3); }
+
+    inline void markDirtyPage(int col, int p) {
+        if (col < dirtyLo_[p]) dirtyLo_[p] = col;
+        if (col > dirtyHi_[p]) dirtyHi_[p] = col;
+    }
+
+    inline void markAllDirty() {
+        for (int p = 0; p < MAX_PAGES; ++p) {
+            dirtyLo_[p] = 0;
+            dirtyHi_[p] = width_ - 1;
+        }
+    }
+
+    inline void flushDirty() {
+        const int pages = height_ >> 3;
+        for (int p = 0; p < pages; ++p) {
+            const uint8_t* cur = buf_ + p * width_;
+            uint8_t* shown = shadow_ + p * width_;
+            const int lo = dirtyLo_[p];
+            const int hi = dirtyHi_[p];
+            dirtyLo_[p] = 0xFF;             // empty span
+            dirtyHi_[p] = 0;
+            if (fullRefresh_) {
+                memcpy(shown, cur, width_);
+                writeSpan(p, 0, shown, width_);
+                continue;
+            }
+            int x = lo;
+            while (x <= hi) {
+                while (x <= hi && cur[x] == shown[x]) ++x;
+                if (x > hi) break;
+                const int start = x;
+                int end = x, gap = 0;
+                for (++x; x <= hi && gap <= RUN_GAP; ++x) {
+                    if (cur[x] != shown[x]) { end = x; gap = 0; }
+                    else ++gap;
+                }
+                x = end + 1;
+                memcpy(shown + start, cur + start, end - start + 1);
+                writeSpan(p, start, shown + start, end - start + 1);
+            }
+        }
+        fullRefresh_ = false;
+    }
+
+    // ---------------- Page buffer raster ----------------
+    // The primitives below write buf_ directly, a byte (8 rows of a column) at a time, instead
+    // of going through setPixel(). buf_ has to be in the panel page layout, LSB on top; a panel
+    // whose columns run right to left sets mirrorX_, as its setPixel() does.
+    bool mirrorX_ = false;
+
+    // color op on the rows in mask of screen column x, page p; x and p must be on screen
+    inline void applyMask(int x, int p, uint8_t mask) {
+        if (!mask) return;
+        if (!buf_) {                        // backend without a page buffer
+            for (int b = 0; b < 8; ++b)
+                if (mask & (1 << b)) plotSlow(x, p * 8 + b);
+            return;
+        }
+        const int col = mirrorX_ ? width_ - 1 - x : x;
+        uint8_t& d = buf_[p * width_ + col];
+        switch (color_) {
+            case UIDisplayColor::WHITE:  d |= mask;  break;
+            case UIDisplayColor::BLACK:  d &= ~mask; break;
+            case UIDisplayColor::INVERT: d ^= mask;  break;
+        }
+        markDirtyPage(col, p);
+    }
+
+    // up to 32 rows of column x from row y down, bit 0 = row y, clipped to the screen
+    inline void applyColumn(int x, int y, uint32_t bits, int rows) {
+        if ((unsigned)x >= width_ || rows <= 0 || y >= height_ || y + rows <= 0) return;
+        if (rows < 32) bits &= (1u << rows) - 1;
+        if (y < 0) {
+            bits >>= -y;
+            rows += y;
+            y = 0;
+        }
+        const int keep = height_ - y;
+        if (keep < rows) bits &= (1u << keep) - 1;
+        uint64_t m = (uint64_t)bits << (y & 7);
+        for (int p = y >> 3; m; ++p, m >>= 8) applyMask(x, p, (uint8_t)m);
+    }
+
+    // brushMask() as a row mask for page p of a vertical run starting at row `start`
+    inline uint8_t brushRows(int start, int p) const {
+        static constexpr uint8_t DASH[4] = { 0x33, 0x99, 0xCC, 0x66 };
+        const int s = (p * 8 - start) & 3;   // brush index of the page's top row, mod 4
+        switch (brush_) {
+            case UIDisplayBrush::SOLID:  return 0xFF;
+            case UIDisplayBrush::DOTTED: return (s & 1) ? 0xAA : 0x55;
+            case UIDisplayBrush::DASHED: return DASH[s];
+        }
+        return 0xFF;
+    }
+
+    inline void plotSlow(int x, int y) {
+        if (colorInvert())      setPixel(x, y, !getPixel(x, y));
+        else if (colorSolid())  setPixel(x, y, true);
+        else                    setPixel(x, y, false);
+    }
+
     // ---------------- Primitive drawing ----------------
 public:
     inline void drawHLine(int x, int y, int w) {
@@ -88,11 +209,13 @@ public:
         if (start < 0) start = 0;
         if (end >= getWidth()) end = getWidth() - 1;
 
-        for (int i = start, idx = 0; i <= end; ++i, ++idx) {
-            if (!brushMask(idx)) continue;
-            if (colorInvert())      setPixel(i, y, !getPixel(i,y));
-            else if (colorSolid())  setPixel(i, y, true);
-            else                    setPixel(i, y, false);
+        const int p = y >> 3;
+        const uint8_t bit = 1 << (y & 7);
+        if (brush_ == UIDisplayBrush::SOLID) {
+            for (int i = start; i <= end; ++i) applyMask(i, p, bit);
+        } else {
+            for (int i = start, idx = 0; i <= end; ++i, ++idx)
+                if (brushMask(idx)) applyMask(i, p, bit);
         }
     }
 
@@ -103,11 +226,10 @@ public:
         if (start < 0) start = 0;
         if (end >= getHeight()) end = getHeight() - 1;
 
-        for (int i = start, idx = 0; i <= end; ++i, ++idx) {
-            if (!brushMask(idx)) continue;
-            if (colorInvert())      setPixel(x, i, !getPixel(x,i));
-            else if (colorSolid())  setPixel(x, i, true);
-            else                    setPixel(x, i, false);
+        for (int p = start >> 3; p <= end >> 3; ++p) {
+            const int lo = max(start - p * 8, 0);
+            const int hi = min(end - p * 8, 7);
+            applyMask(x, p, (0xFF >> (7 - hi)) & (0xFF << lo) & brushRows(start, p));
         }
     }
 
@@ -121,11 +243,7 @@ public:
         int idx = 0;
 
         while (true) {
-            if (brushMask(idx)) {
-                if (colorInvert())      setPixel(x0, y0, !getPixel(x0,y0));
-                else if (colorSolid())  setPixel(x0, y0, true);
-                else                    setPixel(x0, y0, false);
-            }
+            if (brushMask(idx)) applyPixel(x0, y0);
             if (x0 == x1 && y0 == y1) break;
             int e2 = err << 1;
             if (e2 >= dy) { err += dy; x0 += sx; }
@@ -141,8 +259,23 @@ public:
         drawVLine(x+w-1, y, h);
     }
 
+    // same pixels as a drawHLine() per row: the brush runs along x
     inline void fillRect(int x, int y, int w, int h) {
-        for (int yy = y; yy < y+h; ++yy) drawHLine(x, yy, w);
+        if (w <= 0 || h <= 0) return;
+        int xs = x, xe = x + w - 1, ys = y, ye = y + h - 1;
+        if (xe < 0 || xs >= getWidth() || ye < 0 || ys >= getHeight()) return;
+        if (xs < 0) xs = 0;
+        if (xe >= getWidth()) xe = getWidth() - 1;
+        if (ys < 0) ys = 0;
+        if (ye >= getHeight()) ye = getHeight() - 1;
+
+        for (int p = ys >> 3; p <= ye >> 3; ++p) {
+            const int lo = max(ys - p * 8, 0);
+            const int hi = min(ye - p * 8, 7);
+            const uint8_t m = (0xFF >> (7 - hi)) & (0xFF << lo);
+            for (int i = xs, idx = 0; i <= xe; ++i, ++idx)
+                if (brushMask(idx)) applyMask(i, p, m);
+        }
     }
 
     inline void drawCircle(int x0, int y0, int di) {
@@ -151,10 +284,7 @@ public:
         int x = 0, y = r, d = 1 - r;
         int idx = 2;
         auto px = [&](int px, int py, int i) {
-            if (!brushMask(i)) return;
-            if (colorInvert())      setPixel(px, py, !getPixel(px,py));
-            else if (colorSolid())  setPixel(px, py, true);
-            else                    setPixel(px, py, false);
+            if (brushMask(i)) applyPixel(px, py);
         };
         while (x <= y - even ) {
             px(x0 + x - even, y0 + y - even, idx - even); // 5 up left
@@ -176,34 +306,40 @@ public:
 
     // ---------------- Text ----------------
 
-		inline void drawChar(int x, int y, char c) {
-				uint8_t uc = uint8_t(c);
-				if (uc < 0x10 || uc > 0xFF) return;   // ignore non-printable
-				const uint8_t* glyph = font_mo[uc - 0x10];
-				const uint8_t scale = (uint8_t)textScale_;
-
-				for (int col = 0; col < 5; ++col) {
-						uint8_t bits = glyph[col];
-
-						for (int row = 0; row < 7; ++row) {
-								if (bits & (1 << row)) {
-										// scaled block draw
-										if (scale == 1) {
-												applyPixel(x + col, y + row);
-										} else {
-												int xs = x + col * scale;
-												int ys = y + row * scale;
-
-												// unrolled small square for scale==2
-												applyPixel(xs,     ys);
-												applyPixel(xs+1,   ys);
-												applyPixel(xs,   ys+1);
-												applyPixel(xs+1, ys+1);
-										}
-								}
-						}
-				}
-		}
+    // glyphs come pre-scaled from UI_FONT; on a page boundary the columns are written as is,
+    // elsewhere they are shifted across two (X1) or three (X2) pages
+    inline void drawChar(int x, int y, char c) {
+        uint8_t uc = uint8_t(c);
+        if (uc < FONT_FIRST) return;   // ignore non-printable
+        const int g = uc - FONT_FIRST;
+        const bool aligned = (y & 7) == 0 && y >= 0;
+
+        if (textScale_ == UITextScale::X1) {
+            const uint8_t* glyph = UI_FONT.x1[g];
+            if (aligned && y < height_) {
+                const int p = y >> 3;
+                for (int col = 0; col < FONT_COLS; ++col)
+                    if ((unsigned)(x + col) < width_) applyMask(x + col, p, glyph[col]);
+            } else {
+                for (int col = 0; col < FONT_COLS; ++col)
+                    applyColumn(x + col, y, glyph[col], 7);
+            }
+        } else {
+            const uint16_t* glyph = UI_FONT.x2[g];
+            if (aligned && y + 16 <= height_) {
+                const int p = y >> 3;
+                for (int col = 0; col < FONT_COLS * 2; ++col) {
+                    if ((unsigned)(x + col) >= width_) continue;
+                    const uint16_t bits = glyph[col >> 1];
+                    applyMask(x + col, p, bits & 0xFF);
+                    applyMask(x + col, p + 1, bits >> 8);
+                }
+            } else {
+                for (int col = 0; col < FONT_COLS * 2; ++col)
+                    applyColumn(x + col, y, glyph[col >> 1], 14);
+            }
+        }
+    }
 
     inline void drawText(int x, int y, const char* txt)  {
         while (*txt) {
@@ -224,43 +360,24 @@ public:
 
     inline void applyPixel(int x, int y) {
         // global color rules
-        if (color_ == UIDisplayColor::WHITE)
-            setPixel(x, y, true);
-        else if (color_ == UIDisplayColor::BLACK)
-            setPixel(x, y, false);
-        else if (color_ == UIDisplayColor::INVERT) {
-            bool cur = getPixel(x,y);
-            setPixel(x, y, !cur);
-        }
+        if ((unsigned)x >= width_ || (unsigned)y >= height_) return;
+        applyMask(x, y >> 3, 1 << (y & 7));
     }
 
 
-		void drawBitmap(
+    // bitmaps are row-major, MSB first; they are gathered a column (up to 32 rows) at a time
+    void drawBitmap(
         int x, int y,
         const uint8_t* bitmap,
         int w, int h,
         bool hFlip = false,
         bool vFlip = false
     ) {
-        int bytesPerRow = (w + 7) / 8;
-
-        for (int j = 0; j < h; ++j) {
-            int srcRow = vFlip ? (h - 1 - j) : j;
-
-            for (int i = 0; i < w; ++i) {
-                int srcCol = hFlip ? (w - 1 - i) : i;
-
-                int byteIndex = srcRow * bytesPerRow + (srcCol / 8);
-                int bitIndex  = 7 - (srcCol % 8);
-
-                if ((bitmap[byteIndex] >> bitIndex) & 1)
-                    applyPixel(x + i, y + j);
-            }
-        }
+        drawBitmapFragment(x, y, bitmap, w, h, 0, 0, w, h, hFlip, vFlip);
     }
 
 
-		void drawBitmapFragment(
+    void drawBitmapFragment(
         int dstX, int dstY,
         const uint8_t* src,
         int srcW, int srcH,
@@ -271,21 +388,24 @@ public:
     ) {
         int bytesPerRow = (srcW + 7) / 8;
 
-        for (int j = 0; j < fragH; ++j) {
-            int srcRow = fragY + (vFlip ? (fragH - 1 - j) : j);
-            if (srcRow < 0 || srcRow >= srcH) continue;
-
-            for (int i = 0; i < fragW; ++i) {
-                int srcCol = fragX + (hFlip ? (fragW - 1 - i) : i);
-                if (srcCol < 0 || srcCol >= srcW) continue;
-
-                int byteIndex = srcRow * bytesPerRow + (srcCol / 8);
-                int bitIndex  = 7 - (srcCol % 8);
-
-                if ((src[byteIndex] >> bitIndex) & 1)
-                    applyPixel(dstX + i, dstY + j);
+        for (int i = 0; i < fragW; ++i) {
+            if ((unsigned)(dstX + i) >= width_) continue;
+            int srcCol = fragX + (hFlip ? (fragW - 1 - i) : i);
+            if (srcCol < 0 || srcCol >= srcW) continue;
+            const uint8_t* colBase = src + (srcCol >> 3);
+            const uint8_t colBit = 0x80 >> (srcCol & 7);
+
+            for (int j0 = 0; j0 < fragH; j0 += 32) {
+                const int n = min(fragH - j0, 32);
+                uint32_t bits = 0;
+                for (int j = 0; j < n; ++j) {
+                    int srcRow = fragY + (vFlip ? (fragH - 1 - j0 - j) : j0 + j);
+                    if (srcRow < 0 || srcRow >= srcH) continue;
+                    if (colBase[srcRow * bytesPerRow] & colBit) bits |= 1u << j;
+                }
+                applyColumn(dstX + i, dstY + j0, bits, n);
             }
-        } 
+        }
     }
 
 
@@ -294,5 +414,3 @@ public:
 
 
 };
-
-
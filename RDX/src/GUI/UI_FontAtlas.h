@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include "font_mo.h"
+
+// font_mo laid out for direct page blits, built at compile time:
+// x1 - one page byte per glyph column, 7 rows, bit 0 on top
+// x2 - the rows doubled into a 16-bit column (two page bytes), drawn into two adjacent columns
+constexpr int FONT_FIRST  = 0x10;
+constexpr int FONT_GLYPHS = 240;
+constexpr int FONT_COLS   = 5;
+
+struct UI_GlyphAtlas {
+    uint8_t  x1[FONT_GLYPHS][FONT_COLS];
+    uint16_t x2[FONT_GLYPHS][FONT_COLS];
+};
+
+constexpr uint16_t widenGlyphColumn(uint8_t bits) {
+    uint16_t w = 0;
+    for (int r = 0; r < 7; ++r)
+        if (bits & (1 << r)) w |= 3u << (2 * r);
+    return w;
+}
+
+constexpr UI_GlyphAtlas makeGlyphAtlas(const uint8_t (&font)[FONT_GLYPHS][FONT_COLS]) {
+    UI_GlyphAtlas a {};
+    for (int g = 0; g < FONT_GLYPHS; ++g) {
+        for (int c = 0; c < FONT_COLS; ++c) {
+            a.x1[g][c] = font[g][c] & 0x7F;     // the 8th row is not part of the cell
+            a.x2[g][c] = widenGlyphColumn(a.x1[g][c]);
+        }
+    }
+    return a;
+}
+
+static constexpr UI_GlyphAtlas UI_FONT = makeGlyphAtlas(font_mo);
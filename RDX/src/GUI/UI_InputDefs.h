@@ -0,0 +1,18 @@
+// UI_InputDefs.h
+#pragma once
+#include <Arduino.h>
+
+enum class UIInputType : uint8_t {
+    NONE = 0,
+    BUTTON,         // value: 1 = press
+    ENCODER,        // value: signed detent steps
+    ENCODER_CLICK,
+    PAGE,           // value: +1 next / -1 previous page
+    FOCUS           // value: +1 next / -1 previous field
+};
+
+struct UIInputEvent {
+    UIInputType type = UIInputType::NONE;
+    uint8_t     id = 0;
+    int16_t     value = 0;
+};
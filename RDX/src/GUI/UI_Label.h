@@ -4,41 +4,23 @@
 
 class UI_Label : public UI_Widget {
 public:
-    String text_;
-    bool focusable_ = false;   // labels default: not focusable
+    UI_Label(int x, int y, int w, int h, const char* txt = "")
+        : UI_Widget(x, y, w, h) { setText(txt); }
 
-    UI_Label(int x, int y, int w, int h, const String& txt)
-        : UI_Widget(x, y, w, h), text_(txt) {}
-
-    inline bool isFocusable() const override { return focusable_; }
-
-    inline void setText(const String& t) {
-        if (t != text_) {
-            text_ = t;
+    inline void setText(const char* t) {
+        if (strncmp(t, text_, sizeof(text_) - 1) != 0) {
+            strncpy(text_, t, sizeof(text_) - 1);
+            text_[sizeof(text_) - 1] = 0;
             dirty_ = true;
         }
     }
+    inline const char* text() const { return text_; }
 
-    // ---------------- DRAW ----------------
+    // text position: slightly inset, vertically centered
     inline void draw(UI_Display& d) override {
-        if (!dirty_ && !globalDirty_) return;
-
-        // draw focus rectangle only if focusable AND focused
-        if (focusable_ && focus_) {
-            d.drawRect(x_, y_, w_, h_);
-        }
-
-        // text position: slightly inset, vertically centered
-        int fh = d.getFontHeight() * (int)d.getTextScale();   // scaled height
-        int ty = y_ + (h_ - fh) / 2;
-        int tx = x_ + 1;
-
-        d.drawText(tx, ty, text_.c_str());
-
-        dirty_ = false;
+        d.drawText(x_ + 1, y_ + (h_ - d.getFontHeight()) / 2, text_);
     }
 
-    inline void onEvent(const UI_Event&) override {
-        // label does nothing
-    }
+private:
+    char text_[22] = {0};   // a full 128 px row
 };
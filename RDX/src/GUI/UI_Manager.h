@@ -1,8 +1,11 @@
 #pragma once
+#include <atomic>
 #include "UI_Page.h"
 #include "UI_Display.h"
 #include "UI_InputDefs.h"   // event structs
 
+// Inputs are posted from the control task and handled by the GUI task in draw(),
+// so pages and widgets only ever run on one task.
 class UI_Manager {
 public:
     inline void setDisplay(UI_Display* d) { disp_ = d; }
@@ -25,6 +28,30 @@ public:
         updateLEDs();
 
         curPage_->onEnter();
+        fullRedraw_ = true;
+    }
+
+    // next/previous bound page, wrapping around
+    inline void stepPage(int dir) {
+        for (int k = 1; k < MAX_PAGES; ++k) {
+            const uint8_t id = (curPageId_ + dir * k + MAX_PAGES * k) % MAX_PAGES;
+            if (pages_[id]) {
+                setPage(id);
+                return;
+            }
+        }
+    }
+
+    inline uint8_t pageId() const { return curPageId_; }
+    inline UI_Page* page() const { return curPage_; }
+
+    // any task: queued for the next draw(), dropped when full
+    inline bool postInput(const UIInputEvent& ev) {
+        const uint8_t w = inHead_.load(std::memory_order_relaxed);
+        if ((uint8_t)(w - inTail_.load(std::memory_order_acquire)) >= IN_QUEUE) return false;
+        inQueue_[w % IN_QUEUE] = ev;
+        inHead_.store(w + 1, std::memory_order_release);
+        return true;
     }
 
     // main event dispatcher --
@@ -41,20 +68,47 @@ public:
                 if (curPage_) curPage_->onInput(ev.id, ev.value);
                 break;
 
+            case UIInputType::PAGE:
+                stepPage(ev.value < 0 ? -1 : 1);
+                break;
+
+            case UIInputType::FOCUS:
+                if (curPage_) curPage_->focusNext(ev.value < 0 ? -1 : 1);
+                break;
+
             default:
                 break;
         }
     }
 
+    // GUI task: handles queued input, redraws what changed and sends it
     inline void draw() {
+        uint8_t r = inTail_.load(std::memory_order_relaxed);
+        while (r != inHead_.load(std::memory_order_acquire)) {
+            handleInput(inQueue_[r % IN_QUEUE]);
+            inTail_.store(++r, std::memory_order_release);
+        }
         if (!disp_ || !curPage_) return;
-        disp_->clear();
-        curPage_->draw(*disp_);
-        disp_->update();
+        const bool full = fullRedraw_;
+        if (full) disp_->clear();
+        fullRedraw_ = false;
+        if (curPage_->draw(*disp_) || full) disp_->update();
+    }
+
+    // next draw() starts from a blank screen
+    inline void redraw() {
+        if (curPage_) curPage_->onEnter();
+        fullRedraw_ = true;
     }
 
 private:
     static constexpr uint8_t MAX_PAGES = 20;
+    static constexpr uint8_t IN_QUEUE = 16;
+
+    UIInputEvent         inQueue_[IN_QUEUE];
+    std::atomic<uint8_t> inHead_{0};
+    std::atomic<uint8_t> inTail_{0};
+    bool        fullRedraw_ = true;
 
     UI_Display* disp_ = nullptr;
     UI_Page*    pages_[MAX_PAGES] = { nullptr };
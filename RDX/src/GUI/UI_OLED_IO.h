@@ -55,11 +55,36 @@
 #define OLED_SPI_FREQ 8000000
 #endif
 
+#ifndef OLED_SPI_DMA
+#define OLED_SPI_DMA 1     // queued DMA transfers through the IDF SPI master, 0 = blocking Arduino SPI
+#endif
+
+#ifndef OLED_SPI_HOST
+#define OLED_SPI_HOST SPI2_HOST
+#endif
+
+#ifndef OLED_SPI_QUEUE
+#define OLED_SPI_QUEUE 16  // transactions in flight
+#endif
+
+#if OLED_USE_SPI && OLED_SPI_DMA
+#include <atomic>
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#endif
+
 
 
 /* ============================================================
    UI_OLED_IO
    Low-level I/O driver for both I2C & SPI
+
+   With OLED_SPI_DMA the SPI transfers are queued and cmd()/data()
+   return at once: a buffer passed to data() must stay unchanged
+   until wait(). The displays send from their shadow frame and
+   wait() before touching it again, so the GUI draws the next
+   frame while the previous one is still going out.
    ============================================================ */
 
 class UI_OLED_IO {
@@ -99,10 +124,33 @@ public:
         }
 
         pinMode(pin_dc_, OUTPUT);
+#if OLED_SPI_DMA
+        dcPin_ = pin_dc_;
+        spi_bus_config_t bus = {};
+        bus.mosi_io_num     = spi_mosi_;
+        bus.miso_io_num     = -1;
+        bus.sclk_io_num     = spi_sck_;
+        bus.quadwp_io_num   = -1;
+        bus.quadhd_io_num   = -1;
+        bus.max_transfer_sz = OLED_WIDTH;       // one page span at most
+        esp_err_t err = spi_bus_initialize(OLED_SPI_HOST, &bus, SPI_DMA_CH_AUTO);
+        if (err == ESP_OK) {
+            spi_device_interface_config_t dev = {};
+            dev.mode           = 0;
+            dev.clock_speed_hz = OLED_SPI_FREQ;
+            dev.spics_io_num   = pin_cs_;
+            dev.queue_size     = OLED_SPI_QUEUE;
+            dev.pre_cb         = dcCallback;
+            dev.post_cb        = doneCallback;
+            err = spi_bus_add_device(OLED_SPI_HOST, &dev, &dev_);
+        }
+        if (err != ESP_OK) ESP_LOGE("OLED", "SPI DMA init failed: %s", esp_err_to_name(err));
+#else
         pinMode(pin_cs_, OUTPUT);
         digitalWrite(pin_cs_, HIGH);
 
         OLED_SPI_PORT.begin(spi_sck_, -1, spi_mosi_);
+#endif
 
         if (pin_rst_ >= 0) {
             pinMode(pin_rst_, OUTPUT);
@@ -121,6 +169,8 @@ public:
     inline void cmd(uint8_t c) {
 #if OLED_USE_I2C
         sendI2C(0x00, &c, 1);
+#elif OLED_SPI_DMA
+        queueSPI(false, &c, 1);
 #else
         writeCommandSPI(c);
 #endif
@@ -132,6 +182,9 @@ public:
     inline void cmd(const uint8_t* seq, size_t n) {
 #if OLED_USE_I2C
         sendI2C(0x00, seq, n);
+#elif OLED_SPI_DMA
+        if (n <= 4) queueSPI(false, seq, n);  // addressing, copied into the transaction
+        else        sendSPI(false, seq, n);   // init sequences
 #else
         for (size_t i = 0; i < n; i++) writeCommandSPI(seq[i]);
 #endif
@@ -143,12 +196,44 @@ public:
     inline void data(const uint8_t* d, size_t n) {
 #if OLED_USE_I2C
         sendI2C(0x40, d, n);
+#elif OLED_SPI_DMA
+        queueSPI(true, d, n);
 #else
         writeDataSPI(d, n);
 #endif
     }
 
+    // --------------------------------------------------------
+    // Block until every queued transfer is out
+    // --------------------------------------------------------
+    inline void wait() {
+#if OLED_USE_SPI && OLED_SPI_DMA
+        while (inFlight_) reapSPI();
+#endif
+    }
+
+    // --------------------------------------------------------
+    // Frame done: fires the completion callback once the
+    // transfers queued so far are out. With DMA it may run in
+    // the SPI interrupt, keep it short (notify a task).
+    // --------------------------------------------------------
+    inline void setOnComplete(void (*cb)(void*), void* arg) {
+        onComplete_ = cb;
+        onCompleteArg_ = arg;
+    }
+
+    inline void endFrame() {
+#if OLED_USE_SPI && OLED_SPI_DMA
+        frameEnd_.store(true);
+        if (pending_.load() == 0 && frameEnd_.exchange(false) && onComplete_) onComplete_(onCompleteArg_);
+#else
+        if (onComplete_) onComplete_(onCompleteArg_);
+#endif
+    }
+
 private:
+    static inline void (*onComplete_)(void*) = nullptr;
+    static inline void* onCompleteArg_ = nullptr;
 
 /* ============================================================
    I2C implementation
@@ -202,6 +287,64 @@ private:
         OLED_SPI_PORT.endTransaction();
         digitalWrite(pin_cs_, HIGH);
     }
+
+#if OLED_SPI_DMA
+    spi_device_handle_t dev_ = nullptr;
+    spi_transaction_t   trans_[OLED_SPI_QUEUE];
+    uint8_t             head_ = 0;
+    uint8_t             inFlight_ = 0;          // queued, result not collected yet
+
+    // shared with the SPI interrupt
+    static inline int                dcPin_ = -1;
+    static inline std::atomic<int>   pending_{0};   // queued, not finished
+    static inline std::atomic<bool>  frameEnd_{false};
+
+    // D/C rides in the transaction's user field
+    static void IRAM_ATTR dcCallback(spi_transaction_t* t) {
+        gpio_set_level((gpio_num_t)dcPin_, (uint32_t)(uintptr_t)t->user);
+    }
+
+    static void IRAM_ATTR doneCallback(spi_transaction_t*) {
+        if (pending_.fetch_sub(1) == 1 && frameEnd_.exchange(false) && onComplete_) onComplete_(onCompleteArg_);
+    }
+
+    inline void reapSPI() {
+        spi_transaction_t* done;
+        spi_device_get_trans_result(dev_, &done, portMAX_DELAY);
+        --inFlight_;
+    }
+
+    inline void queueSPI(bool isData, const uint8_t* p, size_t n) {
+        if (!dev_ || !n) return;
+        if (inFlight_ == OLED_SPI_QUEUE) reapSPI();   // slots are reused in order
+        spi_transaction_t& t = trans_[head_];
+        head_ = (head_ + 1) % OLED_SPI_QUEUE;
+        t = {};
+        t.length = n * 8;
+        t.user = (void*)(uintptr_t)isData;
+        if (n <= 4) {
+            t.flags = SPI_TRANS_USE_TXDATA;
+            memcpy(t.tx_data, p, n);
+        } else {
+            t.tx_buffer = p;
+        }
+        pending_.fetch_add(1);
+        if (spi_device_queue_trans(dev_, &t, portMAX_DELAY) == ESP_OK) ++inFlight_;
+        else pending_.fetch_sub(1);
+    }
+
+    // blocking, for sequences that aren't kept around
+    inline void sendSPI(bool isData, const uint8_t* p, size_t n) {
+        if (!dev_ || !n) return;
+        wait();
+        spi_transaction_t t = {};
+        t.length = n * 8;
+        t.tx_buffer = p;
+        t.user = (void*)(uintptr_t)isData;
+        pending_.fetch_add(1);
+        if (spi_device_polling_transmit(dev_, &t) != ESP_OK) pending_.fetch_sub(1);
+    }
+#endif
 #endif
 };
 
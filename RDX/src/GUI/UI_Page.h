@@ -1,18 +1,32 @@
+#pragma once
+#include <vector>
+#include "UI_Widget.h"
+
 class UI_Page {
 public:
     virtual ~UI_Page() {}
 
-    virtual void onEnter() {}
+    // whole page is drawn anew on entry
+    virtual void onEnter() {
+        for (auto* w : widgets_) w->invalidate();
+    }
     virtual void onExit() {}
 
-    virtual void draw(UI_Display& d) {
+    inline void add(UI_Widget* w) { widgets_.push_back(w); }
+
+    // redraws the widgets that changed, true if any did
+    virtual bool draw(UI_Display& d) {
+        bool drew = false;
         for (auto* w : widgets_)
-            w->draw(d);
+            drew |= w->refresh(d);
+        return drew;
     }
 
     virtual void onInput(uint8_t encoderId, int16_t value) {
         if (encoderId < bindings_.size() && bindings_[encoderId])
             bindings_[encoderId]->onInput(encoderId, value);
+        else if (UI_Widget* w = focused())
+            w->onInput(encoderId, value);
     }
 
     inline void bindEncoder(uint8_t encId, UI_Widget* w) {
@@ -20,7 +34,30 @@ public:
         bindings_[encId] = w;
     }
 
+    // moves the focus to the next focusable widget in dir, wrapping around
+    virtual void focusNext(int dir) {
+        const int n = (int)widgets_.size();
+        if (n == 0) return;
+        int i = focus_ >= 0 ? focus_ : (dir > 0 ? -1 : 0);
+        for (int k = 0; k < n; ++k) {
+            i = (i + dir + n) % n;
+            if (widgets_[i]->isFocusable()) {
+                setFocus(i);
+                return;
+            }
+        }
+    }
+
+    inline UI_Widget* focused() const { return focus_ >= 0 ? widgets_[focus_] : nullptr; }
+
 protected:
+    inline void setFocus(int i) {
+        if (focus_ >= 0) widgets_[focus_]->setFocus(false);
+        focus_ = i;
+        if (focus_ >= 0) widgets_[focus_]->setFocus(true);
+    }
+
     std::vector<UI_Widget*> widgets_;
     std::vector<UI_Widget*> bindings_;   // encoder > widget mapping
+    int focus_ = -1;
 };
@@ -9,6 +9,7 @@ public:
         width_  = OLED_WIDTH;
         height_ = OLED_HEIGHT;
         buf_    = buffer_;
+        shadow_ = shadowBuf_;
     }
 
     void begin() {
@@ -23,27 +24,25 @@ public:
 
     inline void clear() override {
         memset(buffer_, 0, sizeof(buffer_));
+        markAllDirty();
     }
 
     inline void update() override {
-        uint8_t pages = height_ >> 3;
-        size_t idx = 0;
-
-        for (uint8_t p = 0; p < pages; p++) {
-            io_.cmd(0xB0 | p);
-            io_.cmd(0x02);
-            io_.cmd(0x10);
-            io_.data(buf_ + idx, width_);
-            idx += width_;
-        }
+        io_.wait();     // previous frame is out, shadow_ is free
+        flushDirty();
+        io_.endFrame();
     }
 
+    // called once a frame has been sent, see UI_OLED_IO::endFrame()
+    inline void onUpdateDone(void (*cb)(void*), void* arg) { io_.setOnComplete(cb, arg); }
+
     inline void setPixel(int x, int y, bool c) override {
         if ((unsigned)x >= width_ || (unsigned)y >= height_) return;
         uint16_t pos = (y >> 3) * width_ + x;
         uint8_t bit  = (y & 7);
         if (c) buf_[pos] |=  (1 << bit);
         else   buf_[pos] &= ~(1 << bit);
+        markDirty(x, y);
     }
 
     inline bool getPixel(int x, int y) const override {
@@ -55,6 +54,16 @@ public:
 private:
     UI_OLED_IO io_;
     uint8_t buffer_[(OLED_WIDTH * OLED_HEIGHT) / 8];
+    uint8_t shadowBuf_[(OLED_WIDTH * OLED_HEIGHT) / 8];   // what the panel shows
+
+    static constexpr uint8_t COL_OFFSET = 2;    // 132-column RAM, 128 visible
+
+    inline void writeSpan(uint8_t page, uint8_t col, const uint8_t* data, size_t len) override {
+        col += COL_OFFSET;
+        const uint8_t addr[] = { (uint8_t)(0xB0 | page), (uint8_t)(0x00 | (col & 0x0F)), (uint8_t)(0x10 | (col >> 4)) };
+        io_.cmd(addr, sizeof(addr));
+        io_.data(data, len);
+    }
 
     void initDisplay() {
         static const uint8_t seq[] = {
@@ -10,6 +10,7 @@ public:
         width_  = OLED_WIDTH;
         height_ = OLED_HEIGHT;
         buf_    = buffer_;
+        shadow_ = shadowBuf_;
     }
 
     void begin() {
@@ -27,6 +28,7 @@ public:
 
     void clear() {
         memset(buffer_, 0x00, sizeof(buffer_));
+        markAllDirty();
     }
 
     void clearRegion(int x, int y, int w, int h) {
@@ -34,23 +36,16 @@ public:
         for (int yy = y; yy < y + h; ++yy) drawHLine(x, yy, w);
     }
 
+    // ST7565 uses page addressing: pages = height/8, only changed spans are sent
     void update() {
-        // ST7565 uses page addressing: pages = height/8
-        uint8_t pages = height_ >> 3;
-        size_t idx = 0;
-        for (uint8_t p = 0; p < pages; ++p) {
-            // set page
-            io_.cmd(0xB0 | p);
-            // set column address to 0 (lower + upper nibble)
-            io_.cmd(0x10); // column MSB = 0
-            io_.cmd(0x00); // column LSB = 0
-
-            // send full width data for this page
-            io_.data(&buffer_[idx], width_);
-            idx += width_;
-        }
+        io_.wait();     // previous frame is out, shadow_ is free
+        flushDirty();
+        io_.endFrame();
     }
 
+    // called once a frame has been sent, see UI_OLED_IO::endFrame()
+    void onUpdateDone(void (*cb)(void*), void* arg) { io_.setOnComplete(cb, arg); }
+
     void setPixel(int x, int y, bool c) {
         if ((unsigned)x >= width_ || (unsigned)y >= height_) return;
 
@@ -62,6 +57,7 @@ public:
         uint8_t bit = y & 7;
         if (c) buffer_[pos] |=  (1 << bit);
         else   buffer_[pos] &= ~(1 << bit);
+        markDirty(x, y);
     }
 
     bool getPixel(int x, int y) const {
@@ -75,6 +71,18 @@ public:
 private:
     UI_OLED_IO io_;
     uint8_t buffer_[(OLED_WIDTH * OLED_HEIGHT) / 8];
+    uint8_t shadowBuf_[(OLED_WIDTH * OLED_HEIGHT) / 8];   // what the panel shows
+
+    void writeSpan(uint8_t page, uint8_t col, const uint8_t* data, size_t len) override {
+        // add the module's column offset here if it has one
+        const uint8_t addr[] = {
+            (uint8_t)(0xB0 | page),
+            (uint8_t)(0x10 | (col >> 4)),   // column MSB
+            (uint8_t)(0x00 | (col & 0x0F))  // column LSB
+        };
+        io_.cmd(addr, sizeof(addr));
+        io_.data(data, len);
+    }
 
     void resetIfNeeded() {
         // if your UI_OLED_IO provides a reset pin, the io_.begin() already toggles it.
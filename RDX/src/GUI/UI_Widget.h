@@ -2,14 +2,50 @@
 #pragma once
 #include <Arduino.h>
 #include "UI_Display.h"
-#include "RDX_State.h"
 
+// A widget owns a box on the screen and redraws only that box, and only when
+// the value it shows has moved (poll()) or it was invalidated.
 class UI_Widget {
 public:
+    UI_Widget() {}
+    UI_Widget(int x, int y, int w, int h) : x_(x), y_(y), w_(w), h_(h) {}
     virtual ~UI_Widget() {}
 
-    inline void setPos(int x, int y) { x_ = x; y_ = y; }
-    inline void setSize(int w, int h) { w_ = w; h_ = h; }
+    inline void setPos(int x, int y) { x_ = x; y_ = y; dirty_ = true; }
+    inline void setSize(int w, int h) { w_ = w; h_ = h; dirty_ = true; }
+
+    inline void invalidate() { dirty_ = true; }
+
+    virtual bool isFocusable() const { return false; }
+    // true if draw() marks the focus itself, otherwise refresh() inverts the box
+    virtual bool drawsFocus() const { return false; }
+    inline void setFocus(bool f) {
+        if (f != focus_) {
+            focus_ = f;
+            dirty_ = true;
+        }
+    }
+    inline bool hasFocus() const { return focus_; }
+
+    // clears the box and draws into it if needed, true if it drew
+    inline bool refresh(UI_Display& d) {
+        const bool changed = poll();
+        if (!changed && !dirty_) return false;
+        d.setBrush(UIDisplayBrush::SOLID);
+        d.setColor(UIDisplayColor::BLACK);
+        d.fillRect(x_, y_, w_, h_);
+        d.setColor(UIDisplayColor::WHITE);
+        d.setTextScale(UITextScale::X1);
+        draw(d);
+        if (focus_ && !drawsFocus()) {
+            d.setBrush(UIDisplayBrush::SOLID);
+            d.setColor(UIDisplayColor::INVERT);
+            d.fillRect(x_, y_, w_, h_);
+            d.setColor(UIDisplayColor::WHITE);
+        }
+        dirty_ = false;
+        return true;
+    }
 
     virtual void draw(UI_Display& d) = 0;
 
@@ -17,5 +53,10 @@ public:
     virtual void onInput(uint8_t inputId, int16_t value) {}
 
 protected:
+    // compares the shown value with its source and caches it, true if it moved
+    virtual bool poll() { return false; }
+
     int x_ = 0, y_ = 0, w_ = 0, h_ = 0;
+    bool dirty_ = true;
+    bool focus_ = false;
 };
@@ -1,5 +1,5 @@
 // width: 256, height: 32, length: 1024
-static uint8_t const  bmp_fx[] = {
+static constexpr uint8_t bmp_fx[] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x0F, 0xA2, 0xF2, 0x20, 0x03, 0x8E, 0x73, 0xE0, 0x1F, 0x0A, 0x88, 0x88, 0x00, 0x72, 0x27, 0x00,
@@ -1,5 +1,5 @@
 // width: 224, height: 32, length: 896
-static uint8_t const bmp_waves[] = {
+static constexpr uint8_t bmp_waves[] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x39, 0xD1, 0x00,
   0x00, 0x7D, 0xE7, 0x00, 0x0E, 0x11, 0x50, 0x44, 0x0E, 0x11, 0x50, 0x70, 0x00, 0x0E, 0x38, 0x00,
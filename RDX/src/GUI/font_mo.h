@@ -1,7 +1,7 @@
-
+#pragma once
 
 // 8 * 5 really, cp437 based
-static uint8_t const  font_mo[240][5] = {
+static constexpr uint8_t font_mo[240][5] = {
 	{ 0x44, 0x44, 0x5F, 0x44, 0x44 },  // 10  16 plus minus
 	{ 0x2A, 0x2A, 0x2A, 0x2A, 0x2A },  // 11  17 congruence
 	{ 0x07, 0x39, 0xC1, 0x01, 0x0F },  // 12  18 
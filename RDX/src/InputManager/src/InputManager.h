@@ -4,8 +4,37 @@
 #include "mux4067.h"
 #include "encoder.h"
 #include "button.h"
+#include "fastio.h"
 #include <vector>
 #include <functional>
+#include <driver/gpio.h>
+#include <driver/pcnt.h>
+
+/**
+* Pins are never polled from the caller's task:
+*  - direct encoders count in the PCNT peripheral (x4 quadrature, glitch filter),
+*  - direct buttons latch their level from a GPIO edge interrupt,
+*  - a low priority input task ticks the debouncers, reads the PCNT counters and scans the
+*    mux stack through the GPIO registers; it sleeps INPUT_IDLE_MS while nothing moves and
+*    is woken by the button interrupt.
+* Events are queued, process() only hands them to the callbacks in the caller's task.
+*/
+
+#ifndef INPUT_SCAN_MS
+  #define INPUT_SCAN_MS       1     // tick while a button is down, an encoder turns or a mux is attached
+#endif
+#ifndef INPUT_IDLE_MS
+  #define INPUT_IDLE_MS       10    // tick while idle, PCNT keeps counting meanwhile
+#endif
+#ifndef INPUT_TASK_PRIO
+  #define INPUT_TASK_PRIO     2
+#endif
+#ifndef INPUT_TASK_CORE
+  #define INPUT_TASK_CORE     1
+#endif
+#ifndef INPUT_QUEUE_LEN
+  #define INPUT_QUEUE_LEN     32
+#endif
 
 class InputManager {
 public:
@@ -59,6 +88,8 @@ public:
         }
     }
 
+    ~InputManager() { end(); }
+
     void setMultiplexer(Mux4067stack* mux) {
         _mux = mux;
         if (_mux) {
@@ -76,6 +107,9 @@ public:
     }
 
     // Direct encoder methods
+    // PCNT units are handed out in order, skipping the ones muxed encoders ask for; pcnt_gpio/pcnt_unit
+    // are only there to keep the signature in line with addMuxedEncoder(). Without a free unit the
+    // encoder is decoded in the input task.
     void addDirectEncoder(uint8_t id, uint8_t pinA, uint8_t pinB,
                          MuxEncoder::encMode mode = MuxEncoder::MODE_FULL_STEP,
                          gpio_num_t pcnt_gpio = GPIO_NUM_NC,
@@ -111,9 +145,18 @@ public:
 
     void initialize(std::function<void(int, int)> encoderCallback,
                    std::function<void(int, MuxButton::btnEvents)> buttonCallback) {
+        end();
         _encoderCallback = encoderCallback;
         _buttonCallback = buttonCallback;
 
+        if (!_queue) _queue = xQueueCreate(INPUT_QUEUE_LEN, sizeof(InputEvent));
+
+        // the scanners only queue, the callbacks run in process()
+        auto postEncoder = [this](int id, int delta) { post(id, EVENT_ENCODER, delta); };
+        auto postButton = [this](int id, MuxButton::btnEvents evt) { post(id, EVENT_BUTTON, evt); };
+
+        uint32_t unitsTaken = 0;
+
         // Initialize multiplexed encoders
         if (_mux) {
             for (const auto& config : _muxedEncoderConfigs) {
@@ -121,10 +164,11 @@ public:
                 enc.bind(config.id, 
                         &(_readings->Y[config.muxerA][config.pinA]),
                         &(_readings->Y[config.muxerB][config.pinB]),
-                        _encoderCallback,
+                        postEncoder,
                         config.mode,
                         config.pcnt_gpio,
                         config.pcnt_unit);
+                if (config.pcnt_gpio >= 0) unitsTaken |= 1u << config.pcnt_unit;
                 _muxedEncoders.push_back(enc);
             }
 
@@ -133,7 +177,7 @@ public:
                 MuxButton btn;
                 btn.bind(config.id,
                         &(_readings->Y[config.muxer][config.pin]),
-                        _buttonCallback);
+                        postButton);
                 
                 // Set button parameters
                 btn.setAutoClick(config.autoClick);
@@ -148,80 +192,88 @@ public:
         }
 
         // Initialize direct encoders
+        int unit = 0;
         for (const auto& config : _directEncoderConfigs) {
             DirectEncoder enc;
             enc.id = config.id;
             enc.pinA = config.pinA;
             enc.pinB = config.pinB;
             enc.mode = config.mode;
-            enc.callback = _encoderCallback;
             
-            // Initialize encoder state
-            enc.oldState = (digitalRead(config.pinA) << 1) | digitalRead(config.pinB);
-            enc.newState = enc.oldState;
-            enc.accumulator = 0;
+            while (unit < PCNT_UNIT_MAX && (unitsTaken & (1u << unit))) ++unit;
+            if (unit < PCNT_UNIT_MAX) {
+                enc.attachPcnt((pcnt_unit_t)unit++);
+            } else {
+                enc.oldState = (fastRead(config.pinA) == LOW) | ((fastRead(config.pinB) == LOW) << 1);
+            }
             
             _directEncoders.push_back(enc);
         }
 
         // Initialize direct buttons
+        _directButtons.reserve(_directButtonConfigs.size());   // the ISRs keep pointers into it
         for (const auto& config : _directButtonConfigs) {
-            DirectButton btn;
-            btn.id = config.id;
+            _directButtons.emplace_back();
+            DirectButton& btn = _directButtons.back();
             btn.gpioPin = config.gpioPin;
             btn.activeLow = config.activeLow;
-            btn.callback = _buttonCallback;
+            btn.owner = this;
+            btn.level = fastRead(config.gpioPin) ^ !config.activeLow;
+            btn.btn.bind(config.id, &btn.level, postButton);
             
             // Set button parameters
-            btn.setAutoClick(config.autoClick);
-            btn.enableLateClick(config.lateClick);
-            btn.setRiseTimeMs(config.riseTime);
-            btn.setFallTimeMs(config.fallTime);
-            btn.setLongPressDelayMs(config.longPressTime);
-            btn.setAutoFirePeriodMs(config.autoFireTime);
-            
-            _directButtons.push_back(btn);
+            btn.btn.setAutoClick(config.autoClick);
+            btn.btn.enableLateClick(config.lateClick);
+            btn.btn.setRiseTimeMs(config.riseTime);
+            btn.btn.setFallTimeMs(config.fallTime);
+            btn.btn.setLongPressDelayMs(config.longPressTime);
+            btn.btn.setAutoFirePeriodMs(config.autoFireTime);
+        }
+
+        xTaskCreatePinnedToCore(inputTask, "input", 3072, this, INPUT_TASK_PRIO, &_task, INPUT_TASK_CORE);
+
+        // ESP_ERR_INVALID_STATE if someone installed the service already, that's fine
+        gpio_install_isr_service(0);
+        for (auto& btn : _directButtons) {
+            gpio_set_intr_type((gpio_num_t)btn.gpioPin, GPIO_INTR_ANYEDGE);
+            gpio_isr_handler_add((gpio_num_t)btn.gpioPin, buttonIsr, &btn);
         }
     }
 
+    // hands the queued events to the callbacks, in the caller's task
     void process() {
-        // Read multiplexer inputs if available
-        if (_mux) {
-            _mux->readAll();
-            
-            // Process multiplexed encoders
-            for (auto& encoder : _muxedEncoders) {
-                encoder.process();
-            }
-            
-            // Process multiplexed buttons
-            for (auto& button : _muxedButtons) {
-                button.process();
+        if (!_queue) return;
+        InputEvent ev;
+        while (xQueueReceive(_queue, &ev, 0) == pdTRUE) {
+            if (ev.kind == EVENT_ENCODER) {
+                if (_encoderCallback) _encoderCallback(ev.id, ev.value);
+            } else {
+                if (_buttonCallback) _buttonCallback(ev.id, (MuxButton::btnEvents)ev.value);
             }
         }
-        
-        // Process direct encoders
-        for (auto& encoder : _directEncoders) {
-            encoder.process();
-        }
-        
-        // Process direct buttons
-        for (auto& button : _directButtons) {
-            button.process();
+    }
+
+    // stops the input task and detaches the interrupts and counters, configs are kept
+    void end() {
+        for (auto& btn : _directButtons) gpio_isr_handler_remove((gpio_num_t)btn.gpioPin);
+        if (_task) {
+            vTaskDelete(_task);
+            _task = nullptr;
         }
-        
-        taskYIELD();
+        for (auto& enc : _directEncoders) enc.detachPcnt();
+        _muxedEncoders.clear();
+        _directEncoders.clear();
+        _muxedButtons.clear();
+        _directButtons.clear();
+        if (_queue) xQueueReset(_queue);
     }
 
     void clearAll() {
+        end();
         _muxedEncoderConfigs.clear();
         _directEncoderConfigs.clear();
         _muxedButtonConfigs.clear();
         _directButtonConfigs.clear();
-        _muxedEncoders.clear();
-        _directEncoders.clear();
-        _muxedButtons.clear();
-        _directButtons.clear();
     }
 
     // Utility methods
@@ -233,6 +285,14 @@ public:
     uint32_t getTotalButtonCount() const { return _muxedButtons.size() + _directButtons.size(); }
 
 private:
+    enum : uint8_t { EVENT_ENCODER, EVENT_BUTTON };
+
+    struct InputEvent {
+        uint8_t id;
+        uint8_t kind;
+        int16_t value;
+    };
+
     // Helper class for direct encoders
     class DirectEncoder {
     public:
@@ -240,136 +300,144 @@ private:
         uint8_t pinA;
         uint8_t pinB;
         MuxEncoder::encMode mode;
-        std::function<void(int, int)> callback;
         
-        int oldState;
-        int newState;
-        int accumulator;
-        
-        void process() {
-            if (!callback) return;
-            
-            // Read current state
-            unsigned int clk = (digitalRead(pinA) == LOW);
-            unsigned int dt = (digitalRead(pinB) == LOW);
-            
-            newState = (clk | (dt << 1));
-            if (newState != oldState) {
-                int stateMux = newState | (oldState << 2);
-                oldState = newState;
-                
-                int delta = 0;
-                if (mode == MuxEncoder::MODE_HALF_STEP || mode == MuxEncoder::MODE_FULL_STEP) {
-                    // Use the step increment tables from the original MuxEncoder
-                    delta = MuxEncoder::stepIncrement[mode][stateMux];
-                } else {
-                    // Handle double and quad step modes
-                    delta = MuxEncoder::stepIncrement[MuxEncoder::MODE_HALF_STEP][stateMux];
-                    accumulator += delta;
-                    
-                    if (newState == 0) {
-                        int needed = (mode == MuxEncoder::MODE_DOUBLE_STEP) ? 2 : 4;
-                        if (abs(accumulator) >= needed) {
-                            delta = (accumulator > 0) ? 1 : -1;
-                            accumulator = 0;
-                        } else {
-                            accumulator = 0;
-                            delta = 0;
-                        }
-                    } else {
-                        delta = 0;
-                    }
-                }
-                
-                if (delta != 0) {
-                    callback(id, delta);
+        int oldState = 0;
+        int accumulator = 0;
+
+        // both edges of both lines, so one detent cycle is 4 counts
+        void attachPcnt(pcnt_unit_t unit) {
+            pcnt_config_t cfg = {
+                .pulse_gpio_num = pinA,
+                .ctrl_gpio_num = pinB,
+                .lctrl_mode = PCNT_MODE_REVERSE,
+                .hctrl_mode = PCNT_MODE_KEEP,
+                .pos_mode = PCNT_COUNT_DEC,
+                .neg_mode = PCNT_COUNT_INC,
+                .counter_h_lim = PCNT_LIMIT,
+                .counter_l_lim = -PCNT_LIMIT,
+                .unit = unit,
+                .channel = PCNT_CHANNEL_0
+            };
+            pcnt_unit_config(&cfg);
+            cfg.pulse_gpio_num = pinB;
+            cfg.ctrl_gpio_num = pinA;
+            cfg.pos_mode = PCNT_COUNT_INC;
+            cfg.neg_mode = PCNT_COUNT_DEC;
+            cfg.channel = PCNT_CHANNEL_1;
+            pcnt_unit_config(&cfg);
+            pcnt_set_filter_value(unit, 1000);      // APB cycles, 12.5 us of contact chatter
+            pcnt_filter_enable(unit);
+            pcnt_counter_pause(unit);
+            pcnt_counter_clear(unit);
+            pcnt_counter_resume(unit);
+            pcntUnit = unit;
+            usePcnt = true;
+            lastCount = 0;
+        }
+
+        void detachPcnt() {
+            if (usePcnt) pcnt_counter_pause(pcntUnit);
+            usePcnt = false;
+        }
+
+        // steps since the last call, 0 if none
+        int read() {
+            int delta = 0;
+            if (usePcnt) {
+                int16_t count = 0;
+                pcnt_get_counter_value(pcntUnit, &count);
+                delta = count - lastCount;
+                lastCount = count;
+                if (count > PCNT_LIMIT / 2 || count < -PCNT_LIMIT / 2) {
+                    pcnt_counter_clear(pcntUnit);   // a few edges may slip in here, once per 8k counts
+                    lastCount = 0;
                 }
+            } else {
+                delta = decode();
             }
+            if (delta == 0) return 0;
+            accumulator += delta;
+            const int steps = accumulator / countsPerStep[mode];
+            accumulator -= steps * countsPerStep[mode];
+            return steps;
         }
-        
-        bool isHiSpeed() const {
-            // Simple speed detection - you can enhance this if needed
-            // For now, return false as direct encoders don't have PCNT support
-            return false;
+
+    private:
+        static constexpr int16_t PCNT_LIMIT = 16000;
+        // quadrature counts per callback step: half, full, double, quad
+        static constexpr int countsPerStep[4] = { 1, 2, 2, 4 };
+
+        bool usePcnt = false;
+        pcnt_unit_t pcntUnit = PCNT_UNIT_0;
+        int16_t lastCount = 0;
+
+        // no PCNT unit left: the same x4 count from the half step table
+        int decode() {
+            const int newState = (fastRead(pinA) == LOW) | ((fastRead(pinB) == LOW) << 1);
+            if (newState == oldState) return 0;
+            const int stateMux = newState | (oldState << 2);
+            oldState = newState;
+            return MuxEncoder::stepIncrement[MuxEncoder::MODE_HALF_STEP][stateMux];
         }
     };
 
-    // Helper class for direct buttons
+    // Helper class for direct buttons: the ISR keeps `level` current, MuxButton debounces it in the input task
     class DirectButton {
     public:
-        uint8_t id;
-        uint8_t gpioPin;
-        bool activeLow;
-        std::function<void(int, MuxButton::btnEvents)> callback;
-        
-        void process() {
-            if (!callback) return;
-            
-            bool currentState = digitalRead(gpioPin);
-            bool buttonActive = activeLow ? !currentState : currentState;
-            
-            unsigned long currentMillis = millis();
-            
-            if (buttonActive != lastState) {
-                if (buttonActive) {
-                    // Button pressed
-                    pressTime = currentMillis;
-                    pressed = true;
-                    callback(id, MuxButton::EVENT_TOUCH);
-                } else {
-                    // Button released
-                    releaseTime = currentMillis;
-                    callback(id, MuxButton::EVENT_RELEASE);
-                    
-                    // Check for click
-                    if (currentMillis - pressTime < longPressThreshold) {
-                        callback(id, MuxButton::EVENT_CLICK);
-                    }
-                    pressed = false;
-                    longPressed = false;
-                }
-                lastState = buttonActive;
-            }
-            
-            // Check for long press
-            if (pressed && !longPressed && (currentMillis - pressTime > longPressThreshold)) {
-                longPressed = true;
-                callback(id, MuxButton::EVENT_LONGPRESS);
-            }
-            
-            // Check for auto click
-            if (autoClickEnabled && longPressed && (currentMillis - lastAutoClickTime > autoClickInterval)) {
-                lastAutoClickTime = currentMillis;
-                callback(id, MuxButton::EVENT_AUTOCLICK);
+        MuxButton btn;
+        uint8_t level = !ACTIVE_STATE;              // ACTIVE_STATE when pressed, whatever the wiring; written by the ISR
+        uint8_t gpioPin = 0;
+        bool activeLow = true;
+        InputManager* owner = nullptr;
+    };
+
+    static void IRAM_ATTR buttonIsr(void* arg) {
+        DirectButton* b = static_cast<DirectButton*>(arg);
+        b->level = fastRead(b->gpioPin) ^ !b->activeLow;
+        BaseType_t woken = pdFALSE;
+        if (b->owner->_task) vTaskNotifyGiveFromISR(b->owner->_task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    static void inputTask(void* arg) {
+        InputManager* self = static_cast<InputManager*>(arg);
+        bool busy = true;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(busy ? INPUT_SCAN_MS : INPUT_IDLE_MS));
+            busy = self->scan();
+        }
+    }
+
+    // one input tick, true while something is in motion
+    bool scan() {
+        bool busy = false;
+        if (_mux) {
+            _mux->readAll();
+            for (auto& encoder : _muxedEncoders) encoder.process();
+            for (auto& button : _muxedButtons) button.process();
+            busy = true;
+        }
+        for (auto& encoder : _directEncoders) {
+            const int steps = encoder.read();
+            if (steps) {
+                post(encoder.id, EVENT_ENCODER, steps);
+                busy = true;
             }
         }
-        
-        void setAutoClick(bool enabled) { autoClickEnabled = enabled; }
-        void enableLateClick(bool enabled) { lateClickEnabled = enabled; }
-        void setRiseTimeMs(uint32_t ms) { riseThreshold = ms; }
-        void setFallTimeMs(uint32_t ms) { fallThreshold = ms; }
-        void setLongPressDelayMs(uint32_t ms) { longPressThreshold = ms; }
-        void setAutoFirePeriodMs(uint32_t ms) { autoClickInterval = ms; }
-        bool isPressed() const { return pressed; }
-        
-    private:
-        bool lastState = false;
-        bool pressed = false;
-        bool longPressed = false;
-        unsigned long pressTime = 0;
-        unsigned long releaseTime = 0;
-        unsigned long lastAutoClickTime = 0;
-        
-        bool autoClickEnabled = false;
-        bool lateClickEnabled = false;
-        uint32_t riseThreshold = 20;
-        uint32_t fallThreshold = 10;
-        uint32_t longPressThreshold = 550;
-        uint32_t autoClickInterval = 500;
-    };
+        for (auto& button : _directButtons) {
+            button.btn.process();
+            busy |= button.btn.pressed();
+        }
+        return busy;
+    }
+
+    inline void post(int id, uint8_t kind, int value) {
+        InputEvent ev = { (uint8_t)id, kind, (int16_t)value };
+        xQueueSend(_queue, &ev, 0);     // full: the controls task is stuck anyway, drop
+    }
 
     Mux4067stack* _mux;
-    Mux4067stack::READINGS* _readings;
+    Mux4067stack::READINGS* _readings = nullptr;
     
     std::vector<MuxedEncoderConfig> _muxedEncoderConfigs;
     std::vector<DirectEncoderConfig> _directEncoderConfigs;
@@ -383,4 +451,7 @@ private:
     
     std::function<void(int, int)> _encoderCallback;
     std::function<void(int, MuxButton::btnEvents)> _buttonCallback;
-};
\ No newline at end of file
+
+    QueueHandle_t _queue = nullptr;
+    TaskHandle_t _task = nullptr;
+};
\ No newline at end of file
@@ -158,9 +158,9 @@ class IRAM_ATTR MuxButton {
     uint32_t autoFireTimer;                       // milliseconds before firing autoclick
     uint32_t autoFireEnabled    = 0;              // should the buttons generate continious clicks when pressed longer than a longPressThreshold
     uint32_t lateClickEnabled   = 0;              // enable registering click after a longPress call
-    uint32_t buttonActive;                        // it's 1 since first touch till the click is confirmed
-    uint32_t pressActive;                         // indicates if the button has been pressed and debounced
-    uint32_t longPressActive;                     // indicates if the button has been long-pressed
+    uint32_t buttonActive       = 0;              // it's 1 since first touch till the click is confirmed
+    uint32_t pressActive        = 0;              // indicates if the button has been pressed and debounced
+    uint32_t longPressActive    = 0;              // indicates if the button has been long-pressed
   
   private:
     uint32_t _id;
@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+* Direct GPIO register access for the input scanner and the button ISR.
+* digitalRead()/digitalWrite() go through the HAL pin checks and take ~20x longer,
+* which adds up when a 4067 stack is scanned every millisecond.
+*/
+
+#include <Arduino.h>
+
+#if defined(ESP32) || defined(ARDUINO_ARCH_ESP32)
+  #include "soc/soc_caps.h"
+  #include "soc/gpio_reg.h"
+
+static inline IRAM_ATTR __attribute__((always_inline)) uint8_t fastRead(uint8_t pin) {
+#if SOC_GPIO_PIN_COUNT > 32
+  if (pin >= 32) return (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
+#endif
+  return (REG_READ(GPIO_IN_REG) >> pin) & 1;
+}
+
+static inline IRAM_ATTR __attribute__((always_inline)) void fastWrite(uint8_t pin, uint8_t val) {
+#if SOC_GPIO_PIN_COUNT > 32
+  if (pin >= 32) {
+    REG_WRITE(val ? GPIO_OUT1_W1TS_REG : GPIO_OUT1_W1TC_REG, 1UL << (pin - 32));
+    return;
+  }
+#endif
+  REG_WRITE(val ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, 1UL << pin);
+}
+
+#else
+static inline uint8_t fastRead(uint8_t pin) { return digitalRead(pin); }
+static inline void fastWrite(uint8_t pin, uint8_t val) { digitalWrite(pin, val); }
+#endif
@@ -38,8 +38,10 @@
   #define WRITE_FUNC    gio::write
   #define READ_FUNC     gio::read  
 #else
-  #define WRITE_FUNC    digitalWrite
-  #define READ_FUNC     digitalRead
+  // same speed, straight to the GPIO registers (fastio.h)
+  #include "fastio.h"
+  #define WRITE_FUNC    fastWrite
+  #define READ_FUNC     fastRead
 #endif
 
 #if ACTIVE_STATE == LOW
@@ -35,6 +35,8 @@ void I2S_Audio::init(eI2sMode select_mode) {
 
 
 #if defined CONFIG_IDF_TARGET_ESP32P4
+  static bool ldo_ready = false; // init() runs again on reconfigure()
+  if (!ldo_ready) {
     sd_pwr_ctrl_ldo_config_t ldo_config;
     #ifndef BOARD_SDMMC_POWER_CHANNEL
       #define BOARD_SDMMC_POWER_CHANNEL 4 // GPIO45 of ESP32P4
@@ -43,11 +45,14 @@ void I2S_Audio::init(eI2sMode select_mode) {
     sd_pwr_ctrl_handle_t pwr_ctrl_handle = NULL;
     sd_pwr_ctrl_new_on_chip_ldo(&ldo_config, &pwr_ctrl_handle);
     sd_pwr_ctrl_set_io_voltage(pwr_ctrl_handle, 3300); // 3v3
+    ldo_ready = true;
+  }
 #endif
 
 	_i2s_mode = select_mode;
-	_read_remain_smp = DMA_BUFFER_LEN;
-	_write_remain_smp = DMA_BUFFER_LEN;
+	_buffer_size = AUDIO_CHANNEL_NUM * _buffer_len * sizeof(BUF_TYPE);
+	_read_remain_smp = _buffer_len;
+	_write_remain_smp = _buffer_len;
 
   #if (CHANNEL_SAMPLE_BYTES == 4)
 	_malloc_caps = ( MALLOC_CAP_INTERNAL | MALLOC_CAP_32BIT );
@@ -76,18 +81,22 @@ void I2S_Audio::init(eI2sMode select_mode) {
   pinMode(I2S_WCLK_PIN, OUTPUT);
 
   i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(_i2s_port, I2S_ROLE_MASTER);
-    chan_cfg.dma_frame_num = DMA_BUFFER_LEN;
-    chan_cfg.dma_desc_num = DMA_BUFFER_NUM;
-  i2s_new_channel(&chan_cfg, &tx_handle, &rx_handle);
+    chan_cfg.dma_frame_num = _buffer_len;
+    chan_cfg.dma_desc_num = _buffer_num;
+  // one channel pair on the same port: rx and tx share BCLK/WS, so input and output
+  // blocks stay sample-locked without any resampling
+  const bool use_out = (_i2s_mode != MODE_IN);
+  const bool use_in = (_i2s_mode != MODE_OUT);
+  i2s_new_channel(&chan_cfg, use_out ? &tx_handle : nullptr, use_in ? &rx_handle : nullptr);
   i2s_std_config_t std_cfg = {
       .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
-      .slot_cfg = I2S_STD_PHILIP_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+      .slot_cfg = I2S_STD_PHILIP_SLOT_DEFAULT_CONFIG(chn_bit_width, I2S_SLOT_MODE_STEREO),
       .gpio_cfg = {
           .mclk = I2S_GPIO_UNUSED,
           .bclk = (gpio_num_t)I2S_BCLK_PIN,
           .ws = (gpio_num_t)I2S_WCLK_PIN,
-          .dout = (gpio_num_t)I2S_DOUT_PIN,
-          .din = I2S_GPIO_UNUSED,
+          .dout = use_out ? (gpio_num_t)I2S_DOUT_PIN : I2S_GPIO_UNUSED,
+          .din = use_in ? (gpio_num_t)I2S_DIN_PIN : I2S_GPIO_UNUSED,
           .invert_flags = {
               .mclk_inv = false,
               .bclk_inv = false,
@@ -96,17 +105,38 @@ void I2S_Audio::init(eI2sMode select_mode) {
       },
   };
 
-  i2s_channel_init_std_mode(tx_handle, &std_cfg);
-  i2s_channel_enable(tx_handle);
+  if (tx_handle) i2s_channel_init_std_mode(tx_handle, &std_cfg);
+  if (rx_handle) i2s_channel_init_std_mode(rx_handle, &std_cfg);
+
+#if I2S_DIRECT_DMA
+  if (tx_handle) {
+    _dma_queue = xQueueCreate(_buffer_num, sizeof(void*));
+    i2s_event_callbacks_t cbs = {};
+    cbs.on_sent = onSent;
+    i2s_channel_register_event_callback(tx_handle, &cbs, this);
+  }
+  if (rx_handle) {
+    _dma_rx_queue = xQueueCreate(_buffer_num, sizeof(void*));
+    i2s_event_callbacks_t cbs = {};
+    cbs.on_recv = onRecv;
+    i2s_channel_register_event_callback(rx_handle, &cbs, this);
+  }
+#endif
+
+  if (rx_handle) i2s_channel_enable(rx_handle);
+  if (tx_handle) i2s_channel_enable(tx_handle);
   
-  // BCLK warm-up
-  int16_t zero[AUDIO_CHANNEL_NUM * DMA_BUFFER_LEN * sizeof(BUF_TYPE)] = {0};
-  size_t w;
-  for (int i = 0; i < 32; i++) {
-      i2s_channel_write(tx_handle, zero, sizeof(zero), &w, portMAX_DELAY);
+  // BCLK warm-up, the freshly calloc'ed output buffer is silence
+  // (no stack array: reconfigure() may run on the audio task)
+  if (tx_handle && _output_buf) {
+    size_t w;
+    for (int i = 0; i < 32; i++) {
+        i2s_channel_write(tx_handle, _output_buf, _buffer_size, &w, portMAX_DELAY);
+    }
   }
 
-  ESP_LOGI(TAG, "I2S started: BCK %d, WCK %d, DAT %d", I2S_BCLK_PIN, I2S_WCLK_PIN, I2S_DOUT_PIN);
+  ESP_LOGI(TAG, "I2S started: BCK %d, WCK %d, DOUT %d, DIN %d, %d x %d frames", I2S_BCLK_PIN, I2S_WCLK_PIN,
+           use_out ? I2S_DOUT_PIN : -1, use_in ? I2S_DIN_PIN : -1, _buffer_num, _buffer_len);
 
 }
 
@@ -114,17 +144,42 @@ void I2S_Audio::deInit() {
 	if (_input_buf) { free(_input_buf); _input_buf = nullptr; }
 	if (_output_buf) { free(_output_buf); _output_buf = nullptr; }
 
-	i2s_channel_disable(tx_handle);
-	i2s_del_channel(tx_handle);
+	if (tx_handle) {
+		i2s_channel_disable(tx_handle);
+		i2s_del_channel(tx_handle);
+		tx_handle = nullptr;
+	}
+	if (rx_handle) {
+		i2s_channel_disable(rx_handle);
+		i2s_del_channel(rx_handle);
+		rx_handle = nullptr;
+	}
+#if I2S_DIRECT_DMA
+	if (_dma_queue) { vQueueDelete(_dma_queue); _dma_queue = nullptr; }
+	if (_dma_rx_queue) { vQueueDelete(_dma_rx_queue); _dma_rx_queue = nullptr; }
+#endif
 
 }
 
+bool I2S_Audio::reconfigure(int buffer_len, int buffer_num) {
+	if (buffer_len < MIN_BLOCK_LEN || buffer_len > MAX_BLOCK_LEN || buffer_num < 2 || buffer_num > MAX_DMA_BUFFER_NUM) {
+		ESP_LOGE(TAG, "Bad DMA setup %d x %d frames", buffer_num, buffer_len);
+		return false;
+	}
+	if (buffer_len == _buffer_len && buffer_num == _buffer_num) return true;
+	deInit();
+	_buffer_len = buffer_len;
+	_buffer_num = buffer_num;
+	init(_i2s_mode);
+	return true;
+}
+
 
 void   I2S_Audio::readBuffer(BUF_TYPE* buf) {
 	size_t bytes_read = 0;
 	int32_t err = 0;
 	err = i2s_channel_read(rx_handle, buf, _buffer_size, &bytes_read, portMAX_DELAY);
-	_read_remain_smp = DMA_BUFFER_LEN;
+	_read_remain_smp = _buffer_len;
 
 	if (err != ESP_OK || bytes_read < _buffer_size) {
 		ESP_LOGI(TAG, "I2S read, err %d bytes read: %d", err,  bytes_read);
@@ -153,7 +208,7 @@ void I2S_Audio::getSamples(float& sampleLeft, float& sampleRight){
 }
 
 void I2S_Audio::getSamples(float* sampleLeft, float* sampleRight, BUF_TYPE* buf ){
-  int n = DMA_BUFFER_LEN - _read_remain_smp;
+  int n = _buffer_len - _read_remain_smp;
 #if AUDIO_CHANNEL_NUM == 2
   *sampleLeft = convertInSample(_input_buf[AUDIO_CHANNEL_NUM * n ]);
   *sampleRight = convertInSample(_input_buf[AUDIO_CHANNEL_NUM * n + 1]);
@@ -167,7 +222,7 @@ void I2S_Audio::getSamples(float* sampleLeft, float* sampleRight, BUF_TYPE* buf
 }
 
 void I2S_Audio::getSamples(float& sampleLeft, float& sampleRight, BUF_TYPE* buf ){  
-  int n = DMA_BUFFER_LEN - _read_remain_smp;
+  int n = _buffer_len - _read_remain_smp;
 #if AUDIO_CHANNEL_NUM == 2
   sampleLeft = convertInSample(_input_buf[AUDIO_CHANNEL_NUM * n ]);
   sampleRight = convertInSample(_input_buf[AUDIO_CHANNEL_NUM * n + 1]);
@@ -189,7 +244,7 @@ void I2S_Audio::putSamples(float& sampleLeft, float& sampleRight){
 }
 
 void I2S_Audio::putSamples(float* sampleLeft, float* sampleRight, BUF_TYPE* buf ){
-  int n = DMA_BUFFER_LEN - _write_remain_smp;
+  int n = _buffer_len - _write_remain_smp;
 #if AUDIO_CHANNEL_NUM == 2
   buf[AUDIO_CHANNEL_NUM * n ] = convertOutSample(*sampleLeft);
   buf[AUDIO_CHANNEL_NUM * n + 1] = convertOutSample(*sampleRight);
@@ -203,7 +258,7 @@ void I2S_Audio::putSamples(float* sampleLeft, float* sampleRight, BUF_TYPE* buf
 }
 
 void I2S_Audio::putSamples(float& sampleLeft, float& sampleRight, BUF_TYPE* buf ){
-  int n = DMA_BUFFER_LEN - _write_remain_smp;
+  int n = _buffer_len - _write_remain_smp;
 #if AUDIO_CHANNEL_NUM == 2
   buf[AUDIO_CHANNEL_NUM * n ] = convertOutSample(sampleLeft);
   buf[AUDIO_CHANNEL_NUM * n + 1] = convertOutSample(sampleRight);
@@ -216,20 +271,130 @@ void I2S_Audio::putSamples(float& sampleLeft, float& sampleRight, BUF_TYPE* buf
   }  
 }
 
-void I2S_Audio::writeBuffers(float* L, float* R) {
-    if (!_output_buf) return;
+void IRAM_ATTR I2S_Audio::convertBlock(const float* L, const float* R, BUF_TYPE* dst, int n) {
+  if (_dither) {
+    // TPDF: difference of two uniform draws, +-1 LSB peak, then rounded to the nearest step.
+    // Only the high 16 bits of each LCG draw are used, the low ones repeat every 2^16.
+    uint32_t seed = _dither_seed;
+    auto draw = [&seed]() {
+      seed = seed * 1664525u + 1013904223u;
+      return (int32_t)(seed >> 16);
+    };
+    for (int i = 0; i < n; ++i) {
+      const float dl = (draw() - draw()) * (1.0f / 65536.0f);
+      const float dr = (draw() - draw()) * (1.0f / 65536.0f);
+      dst[2 * i + 0] = saturate(lrintf(L[i] * OUT_SCALE + dl)) << OUT_SHIFT;
+      dst[2 * i + 1] = saturate(lrintf(R[i] * OUT_SCALE + dr)) << OUT_SHIFT;
+    }
+    _dither_seed = seed;
+    return;
+  }
+
+  // 4 frames per pass: independent loads/converts keep the FPU pipeline busy
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const int32_t l0 = (int32_t)(L[i + 0] * OUT_SCALE);
+    const int32_t r0 = (int32_t)(R[i + 0] * OUT_SCALE);
+    const int32_t l1 = (int32_t)(L[i + 1] * OUT_SCALE);
+    const int32_t r1 = (int32_t)(R[i + 1] * OUT_SCALE);
+    const int32_t l2 = (int32_t)(L[i + 2] * OUT_SCALE);
+    const int32_t r2 = (int32_t)(R[i + 2] * OUT_SCALE);
+    const int32_t l3 = (int32_t)(L[i + 3] * OUT_SCALE);
+    const int32_t r3 = (int32_t)(R[i + 3] * OUT_SCALE);
+    BUF_TYPE* d = dst + 2 * i;
+    d[0] = saturate(l0) << OUT_SHIFT;
+    d[1] = saturate(r0) << OUT_SHIFT;
+    d[2] = saturate(l1) << OUT_SHIFT;
+    d[3] = saturate(r1) << OUT_SHIFT;
+    d[4] = saturate(l2) << OUT_SHIFT;
+    d[5] = saturate(r2) << OUT_SHIFT;
+    d[6] = saturate(l3) << OUT_SHIFT;
+    d[7] = saturate(r3) << OUT_SHIFT;
+  }
+  for (; i < n; ++i) {
+    dst[2 * i + 0] = saturate((int32_t)(L[i] * OUT_SCALE)) << OUT_SHIFT;
+    dst[2 * i + 1] = saturate((int32_t)(R[i] * OUT_SCALE)) << OUT_SHIFT;
+  }
+}
 
-    for (int i = 0; i < DMA_BUFFER_LEN; ++i) {
-        int16_t l = convertOutSample(L[i]);
-        int16_t r = convertOutSample(R[i]);
+#if I2S_DIRECT_DMA
+bool IRAM_ATTR I2S_Audio::onSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+  I2S_Audio* self = (I2S_Audio*)user_ctx;
+  BaseType_t woken = pdFALSE;
+  void* buf = event->dma_buf;
+  xQueueSendFromISR(self->_dma_queue, &buf, &woken);
+  return woken == pdTRUE;
+}
 
-#if CHANNEL_SAMPLE_BYTES == 4
-        _output_buf[i] = (uint16_t)l | ((uint32_t)(uint16_t)r << 16);
-#else
-        _output_buf[2 * i + 0] = l;
-        _output_buf[2 * i + 1] = r;
+bool IRAM_ATTR I2S_Audio::onRecv(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+  I2S_Audio* self = (I2S_Audio*)user_ctx;
+  BaseType_t woken = pdFALSE;
+  void* buf = event->dma_buf;
+  // reader fell behind: drop the oldest block, it's about to be overwritten by the DMA anyway
+  if (xQueueIsQueueFullFromISR(self->_dma_rx_queue)) {
+    void* old;
+    xQueueReceiveFromISR(self->_dma_rx_queue, &old, &woken);
+  }
+  xQueueSendFromISR(self->_dma_rx_queue, &buf, &woken);
+  return woken == pdTRUE;
+}
 #endif
+
+void IRAM_ATTR I2S_Audio::convertInBlock(const BUF_TYPE* src, float* L, float* R, int n) {
+  const float k = int_to_float;
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const BUF_TYPE* s = src + 2 * i;
+    const float l0 = s[0] * k;
+    const float r0 = s[1] * k;
+    const float l1 = s[2] * k;
+    const float r1 = s[3] * k;
+    const float l2 = s[4] * k;
+    const float r2 = s[5] * k;
+    const float l3 = s[6] * k;
+    const float r3 = s[7] * k;
+    L[i + 0] = l0; R[i + 0] = r0;
+    L[i + 1] = l1; R[i + 1] = r1;
+    L[i + 2] = l2; R[i + 2] = r2;
+    L[i + 3] = l3; R[i + 3] = r3;
+  }
+  for (; i < n; ++i) {
+    L[i] = src[2 * i + 0] * k;
+    R[i] = src[2 * i + 1] * k;
+  }
+}
+
+bool I2S_Audio::readBuffers(float* L, float* R) {
+#if I2S_DIRECT_DMA
+    // convert straight out of the DMA buffer the driver just filled: no staging copy
+    void* dma = nullptr;
+    if (_dma_rx_queue && xQueueReceive(_dma_rx_queue, &dma, portMAX_DELAY) == pdTRUE && dma) {
+        convertInBlock((const BUF_TYPE*)dma, L, R, _buffer_len);
+        return true;
     }
+#endif
+    if (!rx_handle || !_input_buf) return false;
+
+    size_t bytes_read = 0;
+    if (i2s_channel_read(rx_handle, _input_buf, _buffer_size, &bytes_read, portMAX_DELAY) != ESP_OK) return false;
+    const int n = bytes_read / WHOLE_SAMPLE_BYTES;
+    convertInBlock(_input_buf, L, R, n);
+    for (int i = n; i < _buffer_len; ++i) L[i] = R[i] = 0.0f;
+    return true;
+}
+
+void I2S_Audio::writeBuffers(float* L, float* R) {
+#if I2S_DIRECT_DMA
+    // wait for the DMA to release a buffer and render straight into it: no staging copy
+    void* dma = nullptr;
+    if (xQueueReceive(_dma_queue, &dma, portMAX_DELAY) == pdTRUE && dma) {
+        convertBlock(L, R, (BUF_TYPE*)dma, _buffer_len);
+        return;
+    }
+#endif
+    if (!_output_buf) return;
+
+    convertBlock(L, R, _output_buf, _buffer_len);
 
     size_t bytes_written = 0;
     i2s_channel_write(tx_handle, _output_buf, _buffer_size, &bytes_written, portMAX_DELAY);
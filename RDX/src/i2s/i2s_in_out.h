@@ -18,6 +18,17 @@
 
 
   #include "driver/i2s_std.h"
+  #include "esp_idf_version.h"
+  #include "freertos/queue.h"
+
+#ifndef I2S_DIRECT_DMA
+  #define I2S_DIRECT_DMA 0
+#endif
+// direct DMA needs the DMA buffer pointer in the on_sent event, available since IDF 5.2
+#if I2S_DIRECT_DMA && (ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 2, 0))
+  #undef I2S_DIRECT_DMA
+  #define I2S_DIRECT_DMA 0
+#endif
 
 
 // converting between float and int here assumes that float signal is normalized within -1.0 .. 1.0 range
@@ -59,8 +70,24 @@ class IRAM_ATTR I2S_Audio {
     const uint32_t              mclk_multiplier = 256;
 #endif
 
+// Block output conversion: scale by a power of two (one trunc.s with scale on Xtensa),
+// saturate in the integer domain (clamps), then left-justify into the slot.
+// 32-bit slots carry 24 significant bits, which is what the DACs resolve anyway.
+#if (CHANNEL_SAMPLE_BYTES == 4)
+    static constexpr float      OUT_SCALE = 8388608.0f;
+    static constexpr int32_t    OUT_MAX   = 8388607;
+    static constexpr int        OUT_SHIFT = 8;
+#else
+    static constexpr float      OUT_SCALE = 32768.0f;
+    static constexpr int32_t    OUT_MAX   = 32767;
+    static constexpr int        OUT_SHIFT = 0;
+#endif
+
     void                        init(eI2sMode i2s_mode = MODE_IN_OUT);
     void                        deInit();
+    // tears the channel down and brings it back with a new DMA frame length/descriptor count,
+    // call it from the task that writes the buffers
+    bool                        reconfigure(int buffer_len, int buffer_num);
     inline void                 setMode(eI2sMode i2s_mode)        {_i2s_mode = (eI2sMode)constrain((int)i2s_mode, 0, (int)MODE_COUNT-1); }
     inline eI2sMode             getMode()                         { return _i2s_mode; }
     inline void                 setSampleRate(int sr)             {_sample_rate = constrain(sr, 0, 192000); }
@@ -71,6 +98,15 @@ class IRAM_ATTR I2S_Audio {
     void                        writeBuffer()                     { writeBuffer(_output_buf); }
 
     void                        writeBuffers(float* L, float* R);
+    // one input block -> separate normalized L/R (MODE_IN / MODE_IN_OUT), false if there's no input
+    bool                        readBuffers(float* L, float* R);
+
+    // float L/R block -> interleaved PCM with saturation (and TPDF dither if enabled)
+    void                        convertBlock(const float* L, const float* R, BUF_TYPE* dst, int n);
+    // interleaved PCM -> float L/R, one pass
+    void                        convertInBlock(const BUF_TYPE* src, float* L, float* R, int n);
+    inline void                 setDither(bool d)                 { _dither = d; }
+    inline bool                 getDither()                       { return _dither; }
 
 
     // functions that read/write the whole custom buffers supplied via pointer argument
@@ -112,6 +148,9 @@ class IRAM_ATTR I2S_Audio {
     inline BUF_TYPE*		getOutputBufPointer()			  { return _output_buf; }
     inline int					getBufSizeBytes()				    { return _buffer_len * WHOLE_SAMPLE_BYTES; }
     inline int					getBufLenSmp()					    { return _buffer_len; }
+    inline int					getBufNum()					        { return _buffer_num; }
+    // output side: the block being rendered plus the queued DMA descriptors
+    inline float				getLatencyMs()					    { return 1000.0f * _buffer_len * (_buffer_num + 1) / (float)_sample_rate; }
     inline int					getChanNum()					      { return _channel_num; }
     inline int					getChanBytes()					    { return CHANNEL_SAMPLE_BYTES; }
     inline int					getReadSamplesRemain()			{ return _read_remain_smp; }
@@ -119,8 +158,21 @@ class IRAM_ATTR I2S_Audio {
     
   protected:
 
-    i2s_chan_handle_t tx_handle;
-    i2s_chan_handle_t rx_handle;
+    i2s_chan_handle_t tx_handle = nullptr;
+    i2s_chan_handle_t rx_handle = nullptr;
+
+    bool                        _dither                           = false;
+    uint32_t                    _dither_seed                      = 0x1234567;
+
+    static inline int32_t       saturate(int32_t v)               { return v < -OUT_MAX - 1 ? -OUT_MAX - 1 : (v > OUT_MAX ? OUT_MAX : v); }
+
+#if I2S_DIRECT_DMA
+    // DMA buffers handed back by the driver once sent, the audio task renders straight into them
+    QueueHandle_t               _dma_queue                        = nullptr;
+    QueueHandle_t               _dma_rx_queue                     = nullptr;  // filled input DMA buffers
+    static bool IRAM_ATTR       onSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+    static bool IRAM_ATTR       onRecv(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+#endif
 
 
     BUF_TYPE*                   allocateBuffer(const char* name);
@@ -130,8 +182,8 @@ class IRAM_ATTR I2S_Audio {
     BUF_TYPE*                   _input_buf                        = nullptr;
     BUF_TYPE*                   _output_buf                       = nullptr;
     uint32_t                    _sample_rate                      = SAMPLE_RATE;
-    const int32_t               _buffer_len                       = DMA_BUFFER_LEN;
-    const int32_t               _buffer_num                       = DMA_BUFFER_NUM;
+    int32_t                     _buffer_len                       = DMA_BUFFER_LEN;
+    int32_t                     _buffer_num                       = DMA_BUFFER_NUM;
     const int32_t               _channel_num                      = AUDIO_CHANNEL_NUM;
     int32_t                     _read_remain_smp                  = DMA_BUFFER_LEN;
     int32_t                     _write_remain_smp                 = DMA_BUFFER_LEN;
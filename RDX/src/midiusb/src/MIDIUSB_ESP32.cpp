@@ -32,6 +32,14 @@ ESP_EVENT_DEFINE_BASE(ARDUINO_USB_MIDI_EVENTS);
 
 MIDIUSB MidiUSB;
 
+static void (*s_rx_cb)(void) = nullptr;
+
+// TinyUSB weak hook, runs in the TinyUSB task when the OUT endpoint got data
+extern "C" void tud_midi_rx_cb(uint8_t itf) {
+    (void)itf;
+    if (s_rx_cb) s_rx_cb();
+}
+
 static uint16_t load_midi_descriptor(uint8_t *dst, uint8_t *itf) {
     uint8_t descriptor[TUSB_DESCRIPTOR_ITF_MIDI_LEN] = {
         TUD_MIDI_DESC_HEAD(*itf, 4, USB_MIDI_NUM_CABLES),
@@ -120,6 +128,7 @@ midiEventPacket_t MIDIUSB::read() {
     return data;
 }
 void MIDIUSB::flush(void) {}
+void MIDIUSB::onReceive(void (*cb)(void)) { s_rx_cb = cb; }
 void MIDIUSB::sendMIDI(midiEventPacket_t event) {
     tud_midi_packet_write((uint8_t *)&event);
 }
@@ -47,6 +47,8 @@ class MIDIUSB
     midiEventPacket_t read(); 
     void flush(void); 
     void sendMIDI(midiEventPacket_t event); 
+    // called from the TinyUSB task whenever packets arrive, e.g. to wake the MIDI reader
+    void onReceive(void (*cb)(void));
 
 };
 
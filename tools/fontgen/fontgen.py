@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""Font and bitmap headers for RDX/src/GUI.
+
+  fontgen.py font   SRC.bdf|SRC.pbm -o font_xx.h [--name font_xx] [--first 16] [--count 240] [--cols 5] [--rows 8]
+  fontgen.py bitmap A.pbm [B.pbm ...] -o bmp_xx.h --name a [--name b ...]
+  fontgen.py export HEADER.h -o OUT.pbm [--name array]
+
+font:   glyphs go out as columns, one byte per column, bit 0 on top (the page layout
+        UI_FONT in UI_FontAtlas.h expects); a PBM source is a sheet of 16 cells per row.
+bitmap: row-major, MSB first, as drawBitmap() reads them.
+export: turns an existing font or bitmap array back into a PBM to edit.
+"""
+
+import argparse
+import re
+import sys
+
+
+# ---------------- PBM ----------------
+
+def read_pbm(path):
+    data = open(path, 'rb').read()
+    tokens = []
+    pos = 0
+
+    def token():
+        nonlocal pos
+        while True:
+            while pos < len(data) and data[pos:pos + 1].isspace():
+                pos += 1
+            if data[pos:pos + 1] == b'#':
+                while pos < len(data) and data[pos:pos + 1] not in (b'\n', b'\r'):
+                    pos += 1
+                continue
+            break
+        start = pos
+        while pos < len(data) and not data[pos:pos + 1].isspace():
+            pos += 1
+        return data[start:pos]
+
+    magic = token()
+    w, h = int(token()), int(token())
+    if magic == b'P4':
+        pos += 1
+        stride = (w + 7) // 8
+        rows = [[(data[pos + y * stride + x // 8] >> (7 - x % 8)) & 1 for x in range(w)] for y in range(h)]
+    elif magic == b'P1':
+        bits = [c - 48 for c in data[pos:] if c in (48, 49)]
+        rows = [bits[y * w:(y + 1) * w] for y in range(h)]
+    else:
+        sys.exit('%s: not a PBM (P1/P4)' % path)
+    return w, h, rows
+
+
+def write_pbm(path, w, h, rows):
+    with open(path, 'wb') as f:
+        f.write(b'P4\n%d %d\n' % (w, h))
+        for row in rows:
+            out = bytearray((w + 7) // 8)
+            for x, v in enumerate(row):
+                if v:
+                    out[x // 8] |= 0x80 >> (x % 8)
+            f.write(out)
+
+
+# ---------------- sources ----------------
+
+def glyphs_from_sheet(path, cols, rows, count):
+    w, h, px = read_pbm(path)
+    per_row = w // cols
+    glyphs = []
+    for g in range(count):
+        cx, cy = (g % per_row) * cols, (g // per_row) * rows
+        if cy + rows > h:
+            glyphs.append([0] * cols)
+            continue
+        glyphs.append([sum(px[cy + r][cx + c] << r for r in range(rows)) for c in range(cols)])
+    return glyphs
+
+
+def glyphs_from_bdf(path, cols, rows, first, count):
+    fbb = None
+    glyphs = {}
+    enc = bbx = None
+    bitmap = None
+    for line in open(path, encoding='latin-1'):
+        parts = line.split()
+        if not parts:
+            continue
+        key = parts[0]
+        if key == 'FONTBOUNDINGBOX':
+            fbb = [int(v) for v in parts[1:5]]
+        elif key == 'ENCODING':
+            enc = int(parts[1])
+        elif key == 'BBX':
+            bbx = [int(v) for v in parts[1:5]]
+        elif key == 'BITMAP':
+            bitmap = []
+        elif key == 'ENDCHAR':
+            glyphs[enc] = (bbx, bitmap)
+            bitmap = None
+        elif bitmap is not None:
+            bitmap.append(int(key, 16) << (32 - len(key) * 4) if key else 0)
+    if fbb is None:
+        sys.exit('%s: no FONTBOUNDINGBOX' % path)
+    ascent = fbb[1] + fbb[3]
+    out = []
+    for code in range(first, first + count):
+        colbits = [0] * cols
+        if code in glyphs:
+            (gw, gh, gx, gy), bm = glyphs[code]
+            top = ascent - (gy + gh)
+            for r, bits in enumerate(bm):
+                y = top + r
+                if not 0 <= y < rows:
+                    continue
+                for c in range(gw):
+                    x = gx - fbb[2] + c
+                    if 0 <= x < cols and (bits >> (31 - c)) & 1:
+                        colbits[x] |= 1 << y
+        out.append(colbits)
+    return out
+
+
+# ---------------- headers ----------------
+
+def font_header(name, glyphs, first, cols, rows, src):
+    lines = ['#pragma once', '',
+             '// %d x %d, first glyph 0x%02X, generated by tools/fontgen/fontgen.py from %s' % (cols, rows, first, src),
+             'static constexpr uint8_t %s[%d][%d] = {' % (name, len(glyphs), cols)]
+    for i, g in enumerate(glyphs):
+        code = first + i
+        sep = ',' if i < len(glyphs) - 1 else ' '
+        lines.append('\t{ %s }%s  // %02X %3d' % (', '.join('0x%02X' % (b & 0xFF) for b in g), sep, code, code))
+    lines.append('};')
+    return lines
+
+
+def bitmap_lines(name, w, h, rows):
+    stride = (w + 7) // 8
+    data = bytearray(stride * h)
+    for y, row in enumerate(rows):
+        for x, v in enumerate(row):
+            if v:
+                data[y * stride + x // 8] |= 0x80 >> (x % 8)
+    lines = ['// width: %d, height: %d, length: %d' % (w, h, len(data)),
+             'static constexpr uint8_t %s[] = {' % name]
+    for i in range(0, len(data), 16):
+        lines.append('  ' + ' '.join('0x%02X,' % b for b in data[i:i + 16]))
+    lines.append('};')
+    return lines
+
+
+def parse_array(text, name):
+    pat = r'(\w+)\s*((?:\[\s*\d*\s*\])+)\s*=\s*\{(.*?)\};'
+    for m in re.finditer(pat, text, re.S):
+        if name and m.group(1) != name:
+            continue
+        body = re.sub(r'//[^\n]*', '', m.group(3))
+        values = [int(v, 0) for v in re.findall(r'0[xX][0-9a-fA-F]+|\b\d+\b', body)]
+        dims = [int(d) if d.strip() else None for d in re.findall(r'\[\s*(\d*)\s*\]', m.group(2))]
+        head = text[:m.start()].rsplit('\n', 3)
+        size = re.search(r'width:\s*(\d+),\s*height:\s*(\d+)', '\n'.join(head[-2:]))
+        return m.group(1), dims, values, size
+    sys.exit('no array%s found' % (' ' + name if name else ''))
+
+
+def write_lines(path, lines, eol):
+    with open(path, 'w', newline='') as f:
+        f.write(eol.join(lines))
+
+
+# ---------------- commands ----------------
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('cmd', choices=['font', 'bitmap', 'export'])
+    ap.add_argument('src', nargs='+')
+    ap.add_argument('-o', '--out', required=True)
+    ap.add_argument('--name', action='append', default=[])
+    ap.add_argument('--first', type=lambda v: int(v, 0), default=0x10)
+    ap.add_argument('--count', type=int, default=240)
+    ap.add_argument('--cols', type=int, default=5)
+    ap.add_argument('--rows', type=int, default=8)
+    ap.add_argument('--eol', choices=['crlf', 'lf'], default='crlf', help='line endings of the header (the tree uses CRLF)')
+    a = ap.parse_args()
+    eol = '\r\n' if a.eol == 'crlf' else '\n'
+
+    if a.cmd == 'font':
+        src = a.src[0]
+        if src.lower().endswith('.bdf'):
+            glyphs = glyphs_from_bdf(src, a.cols, a.rows, a.first, a.count)
+        else:
+            glyphs = glyphs_from_sheet(src, a.cols, a.rows, a.count)
+        name = a.name[0] if a.name else 'font_' + re.sub(r'\W', '_', src.rsplit('/', 1)[-1].rsplit('.', 1)[0])
+        write_lines(a.out, font_header(name, glyphs, a.first, a.cols, a.rows, src.rsplit('/', 1)[-1]), eol)
+
+    elif a.cmd == 'bitmap':
+        if len(a.name) != len(a.src):
+            sys.exit('one --name per source')
+        lines = []
+        for src, name in zip(a.src, a.name):
+            if lines:
+                lines.append('')
+            w, h, rows = read_pbm(src)
+            lines += bitmap_lines(name, w, h, rows)
+        write_lines(a.out, lines, eol)
+
+    else:
+        text = open(a.src[0], encoding='utf-8', errors='replace').read().replace('\r\n', '\n')
+        name, dims, values, size = parse_array(text, a.name[0] if a.name else None)
+        if len(dims) == 2:
+            count, cols = dims[0] or len(values) // dims[1], dims[1]
+            per_row = 16
+            w, h = per_row * cols, ((count + per_row - 1) // per_row) * a.rows
+            rows = [[0] * w for _ in range(h)]
+            for g in range(count):
+                cx, cy = (g % per_row) * cols, (g // per_row) * a.rows
+                for c in range(cols):
+                    for r in range(a.rows):
+                        rows[cy + r][cx + c] = (values[g * cols + c] >> r) & 1
+        else:
+            if not size:
+                sys.exit('%s: no "// width: W, height: H" line above the array' % name)
+            w, h = int(size.group(1)), int(size.group(2))
+            stride = (w + 7) // 8
+            rows = [[(values[y * stride + x // 8] >> (7 - x % 8)) & 1 for x in range(w)] for y in range(h)]
+        write_pbm(a.out, w, h, rows)
+
+
+if __name__ == '__main__':
+    main()
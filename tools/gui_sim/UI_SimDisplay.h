@@ -0,0 +1,159 @@
+// UI_SimDisplay.h
+#pragma once
+#include <Arduino.h>
+#include <vector>
+#include <string>
+#include "UI_Display.h"
+
+// PC backend for UI_Display: the same page layout as the OLED drivers (one byte = 8 rows of
+// a column), a simulated panel RAM fed through the dirty-region flush, and counters for the
+// benchmark. Frames are saved from what the panel would show, not from the draw buffer.
+class UI_SimDisplay : public UI_Display {
+public:
+  struct Stats {
+    uint32_t pixelCalls = 0;    // setPixel()
+    uint32_t updates = 0;       // update() calls that sent anything
+    uint32_t spans = 0;         // writeSpan() calls, each costs an address command on the bus
+    uint32_t bytes = 0;         // data bytes sent
+  };
+
+  UI_SimDisplay(int w = 128, int h = 64) : frame_(w * h / 8), shadowBuf_(w * h / 8), panel_(w * h / 8) {
+    width_ = w;
+    height_ = h;
+    buf_ = frame_.data();
+    shadow_ = shadowBuf_.data();
+  }
+
+  void begin() { clear(); invalidate(); }
+
+  void setPixel(int x, int y, bool color) override {
+    ++stats_.pixelCalls;
+    if ((unsigned)x >= width_ || (unsigned)y >= height_) return;
+    uint8_t& b = buf_[(y >> 3) * width_ + x];
+    const uint8_t m = 1 << (y & 7);
+    if (color) b |= m;
+    else       b &= ~m;
+    markDirty(x, y);
+  }
+
+  bool getPixel(int x, int y) const override {
+    if ((unsigned)x >= width_ || (unsigned)y >= height_) return false;
+    return (buf_[(y >> 3) * width_ + x] >> (y & 7)) & 1;
+  }
+
+  int getWidth() const override { return width_; }
+  int getHeight() const override { return height_; }
+
+  void update() override {
+    const uint32_t spans = stats_.spans;
+    flushDirty();
+    if (stats_.spans != spans) ++stats_.updates;
+  }
+
+  void clear() override {
+    memset(buf_, 0, frame_.size());
+    markAllDirty();
+  }
+
+  inline const Stats& stats() const { return stats_; }
+  inline void resetStats() { stats_ = Stats(); }
+
+  // panel RAM, i.e. what a real display shows after the last update()
+  inline bool panelPixel(int x, int y) const { return (panel_[(y >> 3) * width_ + x] >> (y & 7)) & 1; }
+  inline bool panelMatchesFrame() const { return !memcmp(panel_.data(), buf_, frame_.size()); }
+
+  // binary PBM (P4), 1 = lit pixel
+  bool savePBM(const std::string& path, int scale = 1) const {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    const int w = width_ * scale, h = height_ * scale;
+    fprintf(f, "P4\n%d %d\n", w, h);
+    std::vector<uint8_t> row((w + 7) / 8);
+    for (int y = 0; y < h; ++y) {
+      std::fill(row.begin(), row.end(), 0);
+      for (int x = 0; x < w; ++x)
+        if (panelPixel(x / scale, y / scale)) row[x >> 3] |= 0x80 >> (x & 7);
+      fwrite(row.data(), 1, row.size(), f);
+    }
+    fclose(f);
+    return true;
+  }
+
+  // 8-bit greyscale PNG, stored (uncompressed) deflate blocks so no zlib is needed
+  bool savePNG(const std::string& path, int scale = 1, uint8_t on = 0xE8, uint8_t off = 0x10) const {
+    const int w = width_ * scale, h = height_ * scale;
+    std::vector<uint8_t> raw;
+    raw.reserve((w + 1) * h);
+    for (int y = 0; y < h; ++y) {
+      raw.push_back(0);   // filter: none
+      for (int x = 0; x < w; ++x) raw.push_back(panelPixel(x / scale, y / scale) ? on : off);
+    }
+
+    std::vector<uint8_t> z = { 0x78, 0x01 };
+    for (size_t pos = 0; pos < raw.size() || pos == 0; ) {
+      const size_t n = std::min<size_t>(65535, raw.size() - pos);
+      z.push_back(pos + n == raw.size() ? 1 : 0);
+      z.push_back(n & 0xFF); z.push_back(n >> 8);
+      z.push_back(~n & 0xFF); z.push_back((~n >> 8) & 0xFF);
+      z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+      pos += n;
+      if (n == 0) break;
+    }
+    uint32_t a = 1, b = 0;
+    for (uint8_t c : raw) { a = (a + c) % 65521; b = (b + a) % 65521; }
+    put32(z, (b << 16) | a);
+
+    std::vector<uint8_t> ihdr;
+    put32(ihdr, w); put32(ihdr, h);
+    ihdr.insert(ihdr.end(), { 8, 0, 0, 0, 0 });   // 8 bit, greyscale
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(sig, 1, 8, f);
+    writeChunk(f, "IHDR", ihdr);
+    writeChunk(f, "IDAT", z);
+    writeChunk(f, "IEND", {});
+    fclose(f);
+    return true;
+  }
+
+  // text dump for quick looks and diffs in a terminal
+  void print(FILE* f = stdout) const {
+    for (int y = 0; y < height_; ++y) {
+      for (int x = 0; x < width_; ++x) fputc(panelPixel(x, y) ? '#' : '.', f);
+      fputc('\n', f);
+    }
+  }
+
+protected:
+  void writeSpan(uint8_t page, uint8_t col, const uint8_t* data, size_t len) override {
+    memcpy(&panel_[page * width_ + col], data, len);
+    ++stats_.spans;
+    stats_.bytes += len;
+  }
+
+private:
+  static void put32(std::vector<uint8_t>& v, uint32_t x) {
+    for (int s = 24; s >= 0; s -= 8) v.push_back((x >> s) & 0xFF);
+  }
+
+  static void writeChunk(FILE* f, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> c;
+    put32(c, data.size());
+    c.insert(c.end(), type, type + 4);
+    c.insert(c.end(), data.begin(), data.end());
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 4; i < c.size(); ++i) {
+      crc ^= c[i];
+      for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    put32(c, ~crc);
+    fwrite(c.data(), 1, c.size(), f);
+  }
+
+  std::vector<uint8_t> frame_;
+  std::vector<uint8_t> shadowBuf_;
+  std::vector<uint8_t> panel_;
+  Stats stats_;
+};
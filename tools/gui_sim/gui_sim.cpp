@@ -0,0 +1,361 @@
+// gui_sim.cpp -- renders the RDX GUI drawing code on a PC
+//
+//   gui_sim frames [dir]      PNG (x4) + PBM of every scene into dir (default: out)
+//   gui_sim print <scene>     the scene as text
+//   gui_sim bench [frames]    time per frame, setPixel calls and bus bytes per scene
+//   gui_sim refs [dir]        write the reference PBMs (default: ref)
+//   gui_sim check [dir]       compare the scenes with the reference PBMs, exit 1 on a mismatch
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+#include <sys/stat.h>
+
+#include "UI_SimDisplay.h"
+#include "bmp_fx.h"
+#include "bmp_waves.h"
+#include "bmp_slider.h"
+#include "UI_Algos.h"
+#include "RDX_Sliders.h"
+#include "RDX_Graph.h"
+#include "RDX_Scope.h"
+#include "UI_Manager.h"
+#include "UI_Label.h"
+#include "RDX_Browser.h"
+
+void rdxLoadPatch(uint32_t) {}
+
+struct Scene {
+  const char* name;
+  std::function<void(UI_Display&, int)> draw;   // one whole frame, starting from a cleared buffer
+};
+
+// ---------------- scenes, close to what the synth pages draw ----------------
+
+static void scenePatch(UI_Display& d, int f) {
+  static const char* names[] = { "DigiChord ", "Mr.Moog   ", "E.Piano 1 ", "Bell Pad  " };
+  d.setColor(UIDisplayColor::WHITE);
+  d.setBrush(UIDisplayBrush::SOLID);
+  d.setTextScale(UITextScale::X2);
+  d.drawTextBytes(4, 10, (const uint8_t*)names[f & 3], 10);
+  d.setTextScale(UITextScale::X1);
+  char t[16];
+  snprintf(t, sizeof(t), "Bank %d-%d", f / 8 % 4 + 1, f % 8 + 1);
+  d.drawText(2, 0, t);
+  d.setBrush(UIDisplayBrush::DOTTED);
+  d.drawHLine(0, 28, 128);
+  drawAlgo(d, 29, f % 12, 35, true);
+}
+
+static void sceneEG(UI_Display& d, int f) {
+  uint8_t levels[4] = { 127, (uint8_t)(90 + f % 30), 64, 0 };
+  uint8_t rates[4] = { (uint8_t)(120 - f % 40), 80, 50, 70 };
+  d.setColor(UIDisplayColor::WHITE);
+  d.setBrush(UIDisplayBrush::SOLID);
+  d.drawText(0, 0, "OP1 EG");
+  drawPager(d, 0, 0, 4, f & 3);
+  drawEG(d, 0, 10, 62, 52, levels, rates, UIEnvType::ENV_AMP, UIEnvMode::ENV_LEVELS);
+  drawEG(d, 66, 10, 62, 52, levels, rates, UIEnvType::ENV_PITCH, UIEnvMode::ENV_RATES);
+}
+
+static void sceneKeyScale(UI_Display& d, int f) {
+  d.setColor(UIDisplayColor::WHITE);
+  d.setBrush(UIDisplayBrush::SOLID);
+  drawKeyScaling(d, 0, 0, 128, 64, f & 3, (f >> 2) & 3, 40 + f % 60, 90 - f % 60);
+}
+
+static void sceneSliders(UI_Display& d, int f) {
+  const int v = (f * 7) % 128;
+  drawSlider1(d, 0, 0, 30, 64, v, 0, 127);
+  drawSlider2(d, 32, 0, 30, 64, v - 64, -64, 63);
+  drawSlider4(d, 64, 0, 30, 64, v, 0, 127);
+  drawSlider5(d, 96, 0, 32, 64, v - 64, -64, 63);
+}
+
+static void sceneFX(UI_Display& d, int f) {
+  d.setColor(UIDisplayColor::WHITE);
+  d.setBrush(UIDisplayBrush::SOLID);
+  drawFX(d, 0, 0, f % 8);
+  drawWave(d, 0, 32, f % 6);
+  drawDividers(d, 4, 32, 32);
+}
+
+static void sceneScope(UI_Display& d, int f) {
+  static UI_FFT<128> fft;
+  int16_t smp[256];
+  uint16_t mag[64];
+  float levels[8];
+  for (int i = 0; i < 256; ++i) {
+    const float t = (i + f * 37) / 44100.0f;
+    smp[i] = (int16_t)(12000.0f * sinf(2.0f * 3.14159265f * 440.0f * t) + 4000.0f * sinf(2.0f * 3.14159265f * 2640.0f * t));
+  }
+  for (int v = 0; v < 8; ++v) levels[v] = 0.5f + 0.5f * sinf(0.3f * f + v);
+  fft.magnitudes(smp + 128, mag);
+  drawScope(d, 0, 0, 128, 32, smp, 256);
+  drawSpectrum(d, 0, 34, 96, 21, mag, 48);
+  drawVoiceBars(d, 100, 34, 28, 21, levels, 8);
+  drawMeter(d, 0, 57, 128, 3, 0.3f, 0.6f);
+  drawMeter(d, 0, 61, 128, 3, 0.25f, 0.5f);
+}
+
+static void sceneInvert(UI_Display& d, int f) {
+  d.setColor(UIDisplayColor::WHITE);
+  d.setBrush(UIDisplayBrush::SOLID);
+  for (int r = 0; r < 8; ++r) {
+    char t[22];
+    snprintf(t, sizeof(t), "Row %d  value %3d", r, (r * 13 + f) % 128);
+    d.drawText(1, r * 8, t);
+  }
+  d.setColor(UIDisplayColor::INVERT);
+  d.fillRect(0, (f % 8) * 8, 128, 8);
+  d.setBrush(UIDisplayBrush::DASHED);
+  d.drawRect(2, 2, 124, 60);
+  d.setBrush(UIDisplayBrush::DOTTED);
+  d.drawCircle(96, 32, 40);
+  d.drawLine(0, 63, 127, 0);
+}
+
+// a list page: X2 title, rows of X1 text on page boundaries and off them
+static void sceneText(UI_Display& d, int f) {
+  static const char* names[] = { "DigiChord", "Mr.Moog", "E.Piano 1", "Bell Pad", "Brass 1", "Strings", "Clav", "Bass 2" };
+  d.setTextScale(UITextScale::X2);
+  d.drawText(0, 0, "PRESETS");
+  d.setTextScale(UITextScale::X1);
+  for (int r = 0; r < 6; ++r) {
+    char t[22];
+    snprintf(t, sizeof(t), "%03d %-10s %c", (f + r) * 3 % 256, names[(f + r) & 7], r == (f % 6) ? '<' : ' ');
+    d.drawText(0, 16 + r * 8 + (r & 1) * (f % 3), t);
+  }
+}
+
+// the browser over a few thousand made-up patches, each frame a fresh full search
+static const RDX_PatchIndex& browseIndex() {
+  static RDX_PatchIndex idx;
+  if (idx.size()) return idx;
+  static const char* stems[] = { "SYNBASS", "E.PIANO", "STRINGS", "BRASS", "ORGAN", "BELLS", "PAD", "LEAD",
+                                 "PLUCK", "CLAV", "MARIMBA", "CHOIR", "SWEEP", "DIGI", "GLASS", "WARM" };
+  uint32_t seed = 12345;
+  auto rnd = [&](int n) { seed = seed * 1664525u + 1013904223u; return (int)((seed >> 8) % n); };
+  for (int i = 0; i < 4096; ++i) {
+    RDX_Patch p;
+    uint8_t* b = reinterpret_cast<uint8_t*>(&p);
+    for (size_t k = 0; k < sizeof(p); ++k) b[k] = rnd(128);
+    char name[16];
+    snprintf(name, sizeof(name), "%-7.7s%3d", i % 5 ? stems[rnd(16)] : "", i);
+    memcpy(p.common.voiceName, name, 10);
+    p.common.algorithm = rnd(12);
+    for (auto& op : p.ops) {
+      op.enable = 1;
+      op.freqMode = rnd(8) == 0;
+      op.pegEnable = rnd(2);
+    }
+    idx.add(p);
+  }
+  return idx;
+}
+
+static void sceneBrowse(UI_Display& d, int f) {
+  static const char* queries[] = { "", "BA", "PD", "EP" };
+  RDX_BrowserPage page;
+  page.setIndex(&browseIndex());
+  const char* q = queries[f & 3];
+  for (const char* c = q; *c; ++c) {
+    page.onInput(0, (int16_t)(strchr("ABCDEFGHIJKLMNOPQRSTUVWXYZ", *c) - "ABCDEFGHIJKLMNOPQRSTUVWXYZ" + 1));
+    page.focusNext(1);
+  }
+  if ((f & 3) == 2) {             // category PAD
+    page.focusNext(1);
+    page.focusNext(1);
+    page.focusNext(1);
+    page.onInput(0, PCAT_PAD + 1);
+  }
+  page.onEnter();
+  page.draw(d);
+  if ((f & 3) == 3) {             // into the hits and down a few
+    for (int i = 0; i < 5; ++i) page.focusNext(1);
+    page.onInput(0, 1);           // the first turn picks the top hit
+    page.onInput(0, 2 + f / 4 % 8);
+    page.draw(d);
+  }
+}
+
+static const Scene SCENES[] = {
+  { "patch",    scenePatch },
+  { "eg",       sceneEG },
+  { "keyscale", sceneKeyScale },
+  { "sliders",  sceneSliders },
+  { "fx",       sceneFX },
+  { "scope",    sceneScope },
+  { "invert",   sceneInvert },
+  { "text",     sceneText },
+  { "browse",   sceneBrowse },
+};
+static constexpr int SCENE_COUNT = sizeof(SCENES) / sizeof(SCENES[0]);
+static constexpr int REF_FRAMES = 3;    // frames per scene in the references
+
+static void render(UI_SimDisplay& d, const Scene& s, int frame) {
+  d.clear();
+  d.setColor(UIDisplayColor::WHITE);
+  d.setBrush(UIDisplayBrush::SOLID);
+  d.setTextScale(UITextScale::X1);
+  s.draw(d, frame);
+  d.update();
+}
+
+static std::string framePath(const std::string& dir, const Scene& s, int frame, const char* ext) {
+  return dir + "/" + s.name + "_" + std::to_string(frame) + ext;
+}
+
+// ---------------- commands ----------------
+
+static int cmdFrames(const std::string& dir) {
+  mkdir(dir.c_str(), 0755);
+  for (const Scene& s : SCENES) {
+    UI_SimDisplay d;
+    d.begin();
+    for (int f = 0; f < REF_FRAMES; ++f) {
+      render(d, s, f);
+      d.savePNG(framePath(dir, s, f, ".png"), 4);
+      d.savePBM(framePath(dir, s, f, ".pbm"));
+    }
+  }
+  printf("%d scenes x %d frames in %s/\n", SCENE_COUNT, REF_FRAMES, dir.c_str());
+  return 0;
+}
+
+static int cmdPrint(const char* name) {
+  for (const Scene& s : SCENES) {
+    if (strcmp(s.name, name)) continue;
+    UI_SimDisplay d;
+    d.begin();
+    render(d, s, 0);
+    d.print();
+    return 0;
+  }
+  fprintf(stderr, "no scene '%s'\n", name);
+  return 1;
+}
+
+static int cmdRefs(const std::string& dir) {
+  mkdir(dir.c_str(), 0755);
+  for (const Scene& s : SCENES) {
+    UI_SimDisplay d;
+    d.begin();
+    for (int f = 0; f < REF_FRAMES; ++f) {
+      render(d, s, f);
+      d.savePBM(framePath(dir, s, f, ".pbm"));
+    }
+  }
+  return 0;
+}
+
+static std::string readFile(const std::string& path) {
+  std::string s;
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return s;
+  char b[4096];
+  size_t n;
+  while ((n = fread(b, 1, sizeof(b), f)) > 0) s.append(b, n);
+  fclose(f);
+  return s;
+}
+
+static int cmdCheck(const std::string& dir) {
+  int bad = 0;
+  const std::string tmp = "/tmp/gui_sim_check.pbm";
+  for (const Scene& s : SCENES) {
+    UI_SimDisplay d;
+    d.begin();
+    for (int f = 0; f < REF_FRAMES; ++f) {
+      render(d, s, f);
+      if (!d.panelMatchesFrame()) {
+        printf("%-9s frame %d: panel differs from the frame buffer after update()\n", s.name, f);
+        ++bad;
+      }
+      d.savePBM(tmp);
+      const std::string ref = readFile(framePath(dir, s, f, ".pbm"));
+      if (ref.empty()) {
+        printf("%-9s frame %d: no reference\n", s.name, f);
+        ++bad;
+      } else if (ref != readFile(tmp)) {
+        printf("%-9s frame %d: differs from %s\n", s.name, f, framePath(dir, s, f, ".pbm").c_str());
+        ++bad;
+      }
+    }
+  }
+  remove(tmp.c_str());
+  printf(bad ? "%d mismatches\n" : "all %d frames match\n", bad ? bad : SCENE_COUNT * REF_FRAMES);
+  return bad ? 1 : 0;
+}
+
+// full: clear + redraw + update every frame; the bus figures are what the dirty-region flush
+// sends for a frame that differs from the previous one as the scene animates
+static inline double nowUs() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int cmdBench(int frames) {
+  printf("%-9s %10s %10s %12s %10s %8s\n", "scene", "us/frame", "draw us", "setPixel/fr", "bytes/fr", "spans/fr");
+  for (const Scene& s : SCENES) {
+    UI_SimDisplay d;
+    d.begin();
+    render(d, s, 0);
+    d.resetStats();
+    double drawUs = 0.0;
+    const double t0 = nowUs();
+    for (int f = 0; f < frames; ++f) {
+      d.clear();
+      d.setColor(UIDisplayColor::WHITE);
+      d.setBrush(UIDisplayBrush::SOLID);
+      d.setTextScale(UITextScale::X1);
+      const double t1 = nowUs();
+      s.draw(d, f);
+      drawUs += nowUs() - t1;
+      d.update();
+    }
+    const double us = nowUs() - t0;
+    const UI_SimDisplay::Stats& st = d.stats();
+    printf("%-9s %10.2f %10.2f %12u %10u %8u\n", s.name, us / frames, drawUs / frames,
+           st.pixelCalls / frames, st.bytes / frames, st.spans / frames);
+  }
+
+  // render-on-change: a page of labels where one value moves per frame
+  UI_SimDisplay d;
+  d.begin();
+  UI_Manager ui;
+  UI_Page page;
+  UI_Label* rows[8];
+  for (int r = 0; r < 8; ++r) {
+    rows[r] = new UI_Label(0, r * 8, 128, 8, "");
+    page.add(rows[r]);
+  }
+  ui.setDisplay(&d);
+  ui.bindPage(0, &page);
+  ui.setPage(0);
+  ui.draw();
+  d.resetStats();
+  const double t0 = nowUs();
+  for (int f = 0; f < frames; ++f) {
+    char t[22];
+    snprintf(t, sizeof(t), "Param %d   %3d", f & 7, f % 128);
+    rows[f & 7]->setText(t);
+    ui.draw();
+  }
+  const double us = nowUs() - t0;
+  const UI_SimDisplay::Stats& st = d.stats();
+  printf("%-9s %10.2f %10s %12u %10u %8u\n", "widgets", us / frames, "-",
+         st.pixelCalls / frames, st.bytes / frames, st.spans / frames);
+  for (auto* r : rows) delete r;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  const std::string cmd = argc > 1 ? argv[1] : "frames";
+  if (cmd == "frames") return cmdFrames(argc > 2 ? argv[2] : "out");
+  if (cmd == "print" && argc > 2) return cmdPrint(argv[2]);
+  if (cmd == "bench") return cmdBench(argc > 2 ? atoi(argv[2]) : 2000);
+  if (cmd == "refs") return cmdRefs(argc > 2 ? argv[2] : "ref");
+  if (cmd == "check") return cmdCheck(argc > 2 ? argv[2] : "ref");
+  fprintf(stderr, "usage: gui_sim frames [dir] | print <scene> | bench [frames] | refs [dir] | check [dir]\n");
+  return 2;
+}
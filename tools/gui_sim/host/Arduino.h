@@ -0,0 +1,36 @@
+// Arduino.h -- just enough of the Arduino core for the GUI headers to build on a PC
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define PROGMEM
+
+typedef bool boolean;
+
+using std::min;
+using std::max;
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline unsigned long micros() {
+  static const auto t0 = std::chrono::steady_clock::now();
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+inline unsigned long millis() { return micros() / 1000; }
+
+// the patch index logs nothing the sim needs
+#define ESP_LOGE(tag, ...) do {} while (0)
+#define ESP_LOGW(tag, ...) do {} while (0)
+#define ESP_LOGI(tag, ...) do {} while (0)
+#define ESP_LOGD(tag, ...) do {} while (0)